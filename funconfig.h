@@ -68,4 +68,13 @@
 #define FUNCONF_SYSTICK_USE_HCLK  1         // Set SYSTICK to use HCLK or HCLK/8.
 #define FUNCONF_USE_DEBUGPRINTF   0
 
+// LCD Driver
+#define LCD_SCAN_IRQ              0         // TIM2 update interrupt writes the frame table
+#define LCD_SCAN_DMA              1         // TIM2 events trigger DMA1 to write the frame table, zero CPU after setup
+#define LCD_SCAN_AWU              2         // main() writes the frame table, standby between half-phases, woken by AWU
+#define LCD_SCAN_ENGINE           LCD_SCAN_IRQ
+#define LCD_SLEEP_WFI             1         // Sleep (WFI) in main() between interrupts instead of spinning
+#define LCD_PROFILE               0         // Time handlers with SysTick->CNT, print over SWIO, needs FUNCONF_USE_DEBUGPRINTF
+#define LCD_GRAYSCALE             0         // 4 intensity levels per segment by frame-rate control over 4 sub-frames
+
 #endif
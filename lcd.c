@@ -8,6 +8,10 @@
 
 #include "ch32fun.h"
 
+#if LCD_PROFILE
+#include <stdio.h>
+#endif
+
 // TN Positive 3-Digit 7-Segment LCD
 //
 //    LCD PINOUT     |  Segments |  Segment Matrix and CH32V003 Pin Mapping
@@ -32,48 +36,322 @@
 #define PIN_SEG1 PC0
 
 // Segments bit order: 0bDECGBFA
-static const uint8_t character_segments[37] = {
-    0b1110111,  // 0: ABCDEF_ = 1111110 -> 1110111
-    0b0010100,  // 1: _BC____ = 0110000 -> 0010100
-    0b1101101,  // 2: AB_DE_G = 1101101 -> 1101101
-    0b1011101,  // 3: ABCD__G = 1111001 -> 1011101
-    0b0011110,  // 4: _BC__FG = 0110011 -> 0011110
-    0b1011011,  // 5: A_CD_FG = 1011011 -> 1011011
-    0b1111011,  // 6: A_CDEFG = 1011111 -> 1111011
-    0b0010101,  // 7: ABC____ = 1110000 -> 0010101
-    0b1111111,  // 8: ABCDEFG = 1111111 -> 1111111
-    0b1011111,  // 9: ABCD_FG = 1111011 -> 1011111
-    0b0111111,  // A: ABC_EFG = 1110111 -> 0111111
-    0b1111010,  // b: __CDEFG = 0011111 -> 1111010
-    0b1100011,  // C: A__DEF_ = 1001110 -> 1100011
-    0b1111100,  // d: _BCDE_G = 0111101 -> 1111100
-    0b1101011,  // E: A__DEFG = 1001111 -> 1101011
-    0b0101011,  // F: A___EFG = 1000111 -> 0101011
-    0b1110011,  // G: A_CDEF_ = 1011110 -> 1110011
-    0b0111110,  // H: _BC_EFG = 0110111 -> 0111110
-    0b0100010,  // I: ____EF_ = 0000110 -> 0100010
-    0b1010100,  // J: _BCD___ = 0111000 -> 1010100
-    0b0111011,  // K: A_C_EFG = 1010111 -> 0111011
-    0b1100010,  // L: ___DEF_ = 0001110 -> 1100010
-    0b1000111,  // M: AB_D_F_ = 1101010 -> 1000111
-    0b0110111,  // N: ABC_EF_ = 1110110 -> 0110111
-    0b1111000,  // o: __CDE_G = 0011101 -> 1111000
-    0b0101111,  // P: AB__EFG = 1100111 -> 0101111
-    0b0011111,  // q: ABC__FG = 1110011 -> 0011111
-    0b0101000,  // r: ____E_G = 0000101 -> 0101000
-    0b1011011,  // S: A_CD_FG = 1011011 -> 1011011
-    0b1101010,  // t: ___DEFG = 0001111 -> 1101010
-    0b1110110,  // U: _BCDEF_ = 0111110 -> 1110110
-    0b1010110,  // V: _BCD_F_ = 0111010 -> 1010110
-    0b1110001,  // W: A_CDE__ = 1011100 -> 1110001
-    0b1001000,  // x: ___D__G = 0001001 -> 1001000
-    0b1011110,  // y: _BCD_FG = 0111011 -> 1011110
-    0b1101101,  // z: AB_DE_G = 1101101 -> 1101101
-    0b0000000,  // (space)              -> 0000000
+//
+// The glyph list is expanded into the GLYPH_ indexes, glyph_com_masks, ascii_glyphs and the compile-time encoder
+// LCD_SEGS(), so they can't drift. X(a, name, c, segs) - a is passed through, name is the glyph index, c is the
+// lowercase character. '*' stands in for the degree sign, which is not 7-bit ASCII.
+#define LCD_GLYPHS(X, a)                                                          \
+    X(a, GLYPH_0,          '0',  0b1110111) /* 0: ABCDEF_ = 1111110 -> 1110111 */ \
+    X(a, GLYPH_1,          '1',  0b0010100) /* 1: _BC____ = 0110000 -> 0010100 */ \
+    X(a, GLYPH_2,          '2',  0b1101101) /* 2: AB_DE_G = 1101101 -> 1101101 */ \
+    X(a, GLYPH_3,          '3',  0b1011101) /* 3: ABCD__G = 1111001 -> 1011101 */ \
+    X(a, GLYPH_4,          '4',  0b0011110) /* 4: _BC__FG = 0110011 -> 0011110 */ \
+    X(a, GLYPH_5,          '5',  0b1011011) /* 5: A_CD_FG = 1011011 -> 1011011 */ \
+    X(a, GLYPH_6,          '6',  0b1111011) /* 6: A_CDEFG = 1011111 -> 1111011 */ \
+    X(a, GLYPH_7,          '7',  0b0010101) /* 7: ABC____ = 1110000 -> 0010101 */ \
+    X(a, GLYPH_8,          '8',  0b1111111) /* 8: ABCDEFG = 1111111 -> 1111111 */ \
+    X(a, GLYPH_9,          '9',  0b1011111) /* 9: ABCD_FG = 1111011 -> 1011111 */ \
+    X(a, GLYPH_A,          'a',  0b0111111) /* A: ABC_EFG = 1110111 -> 0111111 */ \
+    X(a, GLYPH_B,          'b',  0b1111010) /* b: __CDEFG = 0011111 -> 1111010 */ \
+    X(a, GLYPH_C,          'c',  0b1100011) /* C: A__DEF_ = 1001110 -> 1100011 */ \
+    X(a, GLYPH_D,          'd',  0b1111100) /* d: _BCDE_G = 0111101 -> 1111100 */ \
+    X(a, GLYPH_E,          'e',  0b1101011) /* E: A__DEFG = 1001111 -> 1101011 */ \
+    X(a, GLYPH_F,          'f',  0b0101011) /* F: A___EFG = 1000111 -> 0101011 */ \
+    X(a, GLYPH_G,          'g',  0b1110011) /* G: A_CDEF_ = 1011110 -> 1110011 */ \
+    X(a, GLYPH_H,          'h',  0b0111110) /* H: _BC_EFG = 0110111 -> 0111110 */ \
+    X(a, GLYPH_I,          'i',  0b0100010) /* I: ____EF_ = 0000110 -> 0100010 */ \
+    X(a, GLYPH_J,          'j',  0b1010100) /* J: _BCD___ = 0111000 -> 1010100 */ \
+    X(a, GLYPH_K,          'k',  0b0111011) /* K: A_C_EFG = 1010111 -> 0111011 */ \
+    X(a, GLYPH_L,          'l',  0b1100010) /* L: ___DEF_ = 0001110 -> 1100010 */ \
+    X(a, GLYPH_M,          'm',  0b1000111) /* M: AB_D_F_ = 1101010 -> 1000111 */ \
+    X(a, GLYPH_N,          'n',  0b0110111) /* N: ABC_EF_ = 1110110 -> 0110111 */ \
+    X(a, GLYPH_O,          'o',  0b1111000) /* o: __CDE_G = 0011101 -> 1111000 */ \
+    X(a, GLYPH_P,          'p',  0b0101111) /* P: AB__EFG = 1100111 -> 0101111 */ \
+    X(a, GLYPH_Q,          'q',  0b0011111) /* q: ABC__FG = 1110011 -> 0011111 */ \
+    X(a, GLYPH_R,          'r',  0b0101000) /* r: ____E_G = 0000101 -> 0101000 */ \
+    X(a, GLYPH_S,          's',  0b1011011) /* S: A_CD_FG = 1011011 -> 1011011 */ \
+    X(a, GLYPH_T,          't',  0b1101010) /* t: ___DEFG = 0001111 -> 1101010 */ \
+    X(a, GLYPH_U,          'u',  0b1110110) /* U: _BCDEF_ = 0111110 -> 1110110 */ \
+    X(a, GLYPH_V,          'v',  0b1010110) /* V: _BCD_F_ = 0111010 -> 1010110 */ \
+    X(a, GLYPH_W,          'w',  0b1110001) /* W: A_CDE__ = 1011100 -> 1110001 */ \
+    X(a, GLYPH_X,          'x',  0b1001000) /* x: ___D__G = 0001001 -> 1001000 */ \
+    X(a, GLYPH_Y,          'y',  0b1011110) /* y: _BCD_FG = 0111011 -> 1011110 */ \
+    X(a, GLYPH_Z,          'z',  0b1101101) /* z: AB_DE_G = 1101101 -> 1101101 */ \
+    X(a, GLYPH_SPACE,      ' ',  0b0000000) /* (space)              -> 0000000 */ \
+    X(a, GLYPH_MINUS,      '-',  0b0001000) /* -: ______G = 0000001 -> 0001000 */ \
+    X(a, GLYPH_UNDERSCORE, '_',  0b1000000) /* _: ___D___ = 0001000 -> 1000000 */ \
+    X(a, GLYPH_EQUALS,     '=',  0b1001000) /* =: ___D__G = 0001001 -> 1001000 */ \
+    X(a, GLYPH_QUOTE,      '"',  0b0000110) /* ": _B___F_ = 0100010 -> 0000110 */ \
+    X(a, GLYPH_APOSTROPHE, '\'', 0b0000010) /* ': _____F_ = 0000010 -> 0000010 */ \
+    X(a, GLYPH_LBRACKET,   '[',  0b1100011) /* [: A__DEF_ = 1001110 -> 1100011 */ \
+    X(a, GLYPH_RBRACKET,   ']',  0b1010101) /* ]: ABCD___ = 1111000 -> 1010101 */ \
+    X(a, GLYPH_DEGREE,     '*',  0b0001111) /* *: AB___FG = 1100011 -> 0001111 */ \
+    X(a, GLYPH_QUESTION,   '?',  0b0101101) /* ?: AB__E_G = 1100101 -> 0101101 */
+
+#define GLYPH_NAME(a, name, c, segs) name,
+enum
+{
+    LCD_GLYPHS(GLYPH_NAME, ) GLYPH_COUNT
+};
+
+// COM segment masks of a glyph at D1, packed in a word, byte n is the segment mask of COM(n+1).
+// Same shifts as calculate_seg_masks(), D2 and D3 are D1 shifted right by 2 and 4 bits.
+#define GLYPH_COM_MASKS(segs)                                                    \
+    ((((segs) & 0x40) >> 1) |            /* COM1: D  bits -> Byte 0, Bit 5   */ \
+     ((uint32_t)((segs) & 0x30) << 8) |  /* COM2: EC bits -> Byte 1, Bit 5-4 */ \
+     ((uint32_t)((segs) & 0x0C) << 18) | /* COM3: GB bits -> Byte 2, Bit 5-4 */ \
+     ((uint32_t)((segs) & 0x03) << 28))  /* COM4: FA bits -> Byte 3, Bit 5-4 */
+#define GLYPH_COM_MASKS_D1(a, name, c, segs) (GLYPH_COM_MASKS(segs) >> 0),
+#define GLYPH_COM_MASKS_D2(a, name, c, segs) (GLYPH_COM_MASKS(segs) >> 2),
+#define GLYPH_COM_MASKS_D3(a, name, c, segs) (GLYPH_COM_MASKS(segs) >> 4),
+
+// [Digit][Glyph] -> packed COM segment masks, a display update is 3 lookups ORed together.
+static const uint32_t glyph_com_masks[3][GLYPH_COUNT] = {
+    {LCD_GLYPHS(GLYPH_COM_MASKS_D1, )},
+    {LCD_GLYPHS(GLYPH_COM_MASKS_D2, )},
+    {LCD_GLYPHS(GLYPH_COM_MASKS_D3, )},
+};
+
+// Compile-time Encoder
+//
+// Constant expressions for string literals, e.g. a message table in flash, shown with show_masks().
+// - LCD_SEGS(ch)   - 0bDECGBFA of a character, a chain of compares over the glyph list, unsupported -> blank.
+// - LCD_MASKS(str) - Packed COM segment masks of the first 3 characters, same as lcd_encode() at runtime.
+//
+//   static const uint32_t messages[] = {LCD_MASKS("on "), LCD_MASKS("off")};
+//   show_masks(messages[state]);
+#define GLYPH_LOWER(ch)                (((ch) >= 'A' && (ch) <= 'Z') ? (ch) | 0x20 : (ch))
+#define GLYPH_MATCH(ch, name, c, segs) (GLYPH_LOWER(ch) == (c)) ? (segs) :
+#define LCD_SEGS(ch)                   (LCD_GLYPHS(GLYPH_MATCH, ch) 0)
+#define LCD_CHAR(str, i)         (sizeof(str) > (i) + 1 ? (str)[(i) < sizeof(str) ? (i) : 0] : ' ')
+#define LCD_MASKS(str)                                   \
+    ((GLYPH_COM_MASKS(LCD_SEGS(LCD_CHAR(str, 0))) >> 0) | \
+     (GLYPH_COM_MASKS(LCD_SEGS(LCD_CHAR(str, 1))) >> 2) | \
+     (GLYPH_COM_MASKS(LCD_SEGS(LCD_CHAR(str, 2))) >> 4))
+
+// 7-bit ASCII -> glyph index, unsupported characters -> GLYPH_SPACE, so a character is a single load in glyph_of().
+#define GLYPH_FIND(ch, name, c, segs) (GLYPH_LOWER(ch) == (c)) ? (name) :
+#define GLYPH_INDEX(ch)               (LCD_GLYPHS(GLYPH_FIND, ch) GLYPH_SPACE)
+#define GLYPH_INDEX_4(ch)             GLYPH_INDEX(ch), GLYPH_INDEX(ch + 1), GLYPH_INDEX(ch + 2), GLYPH_INDEX(ch + 3)
+#define GLYPH_INDEX_16(ch)            GLYPH_INDEX_4(ch), GLYPH_INDEX_4(ch + 4), GLYPH_INDEX_4(ch + 8), GLYPH_INDEX_4(ch + 12)
+
+static const uint8_t ascii_glyphs[128] = {
+    GLYPH_INDEX_16(0x00), GLYPH_INDEX_16(0x10), GLYPH_INDEX_16(0x20), GLYPH_INDEX_16(0x30),
+    GLYPH_INDEX_16(0x40), GLYPH_INDEX_16(0x50), GLYPH_INDEX_16(0x60), GLYPH_INDEX_16(0x70),
 };
 
-static const uint8_t com_pins[4]  = {PIN_COM1, PIN_COM2, PIN_COM3, PIN_COM4};
-volatile uint8_t     seg_masks[4] = {0, 0, 0, 0};
+static const uint8_t    com_pins[4] = {PIN_COM1, PIN_COM2, PIN_COM3, PIN_COM4};
+static volatile uint8_t dirty       = 0;  // 1 - seg_masks changed by lcd_set_digit() since the last frame build
+
+// Shown segments, packed COM masks like glyph_com_masks, byte n is COM(n+1), 6 bits each.
+// Published with one aligned 32-bit store, atomic on RV32, and read with one load by the frame build, so the
+// build reads the old or the new content, never a mix. See build_frame() for the builds themselves.
+volatile uint32_t seg_masks = 0;
+
+// Grayscale
+//
+// Enabled by LCD_GRAYSCALE in funconfig.h. Each segment has a level 0 - 3, stored in 2 bit planes per COM mask.
+// Frame-rate control - the SEG words of 4 sub-frames are built at once, a segment is lit in a sub-frame if its
+// level reaches the minimum level of the sub-frame in subframe_levels, so level 1 is lit 1/4 of the frames,
+// level 2 every other frame, level 3 always. The scan engines step through the sub-frames like one long frame,
+// at no extra cost per half-phase. Every sub-frame is a complete frame, DC balance holds.
+#if LCD_GRAYSCALE
+#define LCD_SUBFRAMES 4
+#define LCD_LEVEL_OFF 0
+#define LCD_LEVEL_MAX 3
+
+static const uint8_t subframe_levels[LCD_SUBFRAMES] = {1, 3, 2, 3};
+
+static uint8_t level_planes[2][4] = {{0x3F, 0x3F, 0x3F, 0x3F}, {0x3F, 0x3F, 0x3F, 0x3F}};  // Bit 0, Bit 1
+#else
+#define LCD_SUBFRAMES 1
+#endif
+
+#define LCD_SEG_WORDS (8 * LCD_SUBFRAMES)  // SEG words per buffer, a power of 2
+
+// Effect overlay, packed COM masks like seg_masks, shown = (seg_masks & effect_keep) | effect_set.
+static volatile uint32_t effect_keep = 0xFFFFFFFF;
+static volatile uint32_t effect_set  = 0;
+
+// Frame Table
+//
+// Register words for the 8 half-phases in the order of drive_mode, so each phase is a single store per register.
+// Written in this order by TIM2_IRQHandler, or streamed by DMA1 in circular mode on TIM2 events.
+// - TIM2 UP  -> DMA1 Channel2 -> GPIOD->BSHR  - COM HIGH/LOW, set before the COM is switched to output
+// - TIM2 CC1 -> DMA1 Channel5 -> GPIOD->CFGLR - COM output, other COMs float
+// - TIM2 CC3 -> DMA1 Channel1 -> GPIOC->BSHR  - SEG1-6
+// - TIM2 CC2 -> DMA1 Channel7 -> GPIOD->CFGLR - All COMs float, only with the all-float slot
+//
+// Each register has its own array, as a DMA channel can only stream contiguous words.
+//
+// The table is double buffered, COM words too, as the COM order can change with the content. Updates write the
+// back buffer and request a swap, the scan engine swaps at the frame boundary, so a frame never mixes old and
+// new digits.
+typedef struct
+{
+    uint32_t gpiod_bshr[2][8];              // [front] is scanned, [front ^ 1] is written by build_frame()
+    uint32_t gpiod_cfglr[2][8];
+    uint32_t gpioc_bshr[2][LCD_SEG_WORDS];
+    uint32_t gpiod_float;                   // GPIOD->CFGLR with all COMs floating, for the all-float slot
+} lcd_frame_t;
+
+static lcd_frame_t      frame;
+static volatile uint8_t front = 0;  // Index of the buffer being scanned
+static volatile uint8_t swap  = 0;  // 1 - Back buffer is ready, swap at the next frame boundary
+
+static uint32_t com_cfglr[4];  // GPIOD->CFGLR with COM i driven, the other COMs floating
+
+// Drive Scheme - order of the 8 half-phases in the frame table, all are DC balanced over the table.
+// - LCD_DRIVE_LINE  - COM1 HIGH, COM1 LOW, COM2 HIGH, ... - each COM slot is inverted in its middle.
+// - LCD_DRIVE_FRAME - COM1-4 HIGH, then COM1-4 LOW - a positive frame and a negative frame of 4 half-phases.
+//   The SEG pins only invert between the 2 frames, the COMs switch once per slot, about half the edges.
+// - LCD_DRIVE_ORDER - frame inversion with the COM order picked for each content by order_coms(), the COMs
+//   whose masks differ in the fewest bits follow each other.
+#define LCD_DRIVE_LINE  0
+#define LCD_DRIVE_FRAME 1
+#define LCD_DRIVE_ORDER 2
+
+static uint8_t drive_mode = LCD_DRIVE_LINE;
+
+// COM words only depend on the pin mapping, build them in lcd_start().
+void build_com_words(void)
+{
+    const uint32_t cfglr = (GPIOD->CFGLR & 0xF000FFF0) | 0x04440004;  // PD0, PD4, PD5, PD6 floating input
+
+    for (uint8_t i = 0; i < 4; i++)
+    {
+        const uint32_t shift = (com_pins[i] & 0x0F) << 2;
+
+        com_cfglr[i] = (cfglr & ~(0x0F << shift)) | ((GPIO_Speed_2MHz | GPIO_CNF_OUT_PP) << shift);
+    }
+    frame.gpiod_float = cfglr;
+}
+
+// Bits set in a 6-bit SEG mask, the SEG pins that toggle between 2 half-phases.
+static uint8_t seg_edges(uint8_t x)
+{
+    x = x - ((x >> 1) & 0x15);
+    x = (x & 0x33) + ((x >> 2) & 0x33);
+    return (x + (x >> 4)) & 0x0F;
+}
+
+// The 3 distinct cycles through 4 COMs, rotations and reversals have the same edges.
+static const uint8_t com_cycles[3][4] = {{0, 1, 2, 3}, {0, 1, 3, 2}, {0, 2, 1, 3}};
+
+// Frame inversion order of the COMs with the fewest SEG edges for the masks, returns the edges per table.
+// Within each frame the SEG pins step from COM to COM, h edges for masks h bits apart. Between the frames they
+// invert and step, 6 - h edges. Over a cycle of the 4 COMs cut open at one step of h bits, the table has
+// 2 x (cycle - h) + 2 x (6 - h) edges, so cut each cycle at its widest step and keep the best cycle.
+// This is 3 x 4 mask compares per content, no search over all 2520 orders of the 8 half-phases, and within
+// ~7% of the best of those on the glyph set.
+static uint8_t order_coms(const uint8_t masks[4], uint8_t order[4])
+{
+    uint8_t best = 0xFF;
+
+    for (uint8_t c = 0; c < 3; c++)
+    {
+        const uint8_t* const cycle  = com_cycles[c];
+        uint8_t              sum    = 0;
+        uint8_t              cut    = 0;
+        uint8_t              widest = 0;
+
+        for (uint8_t k = 0; k < 4; k++)
+        {
+            const uint8_t h = seg_edges(masks[cycle[k]] ^ masks[cycle[(k + 1) & 3]]);
+
+            sum += h;
+            if (h > widest)
+            {
+                widest = h;
+                cut    = (k + 1) & 3;  // Start after the widest step
+            }
+        }
+
+        const uint8_t edges = (sum << 1) - (widest << 2) + 12;
+        if (edges < best)
+        {
+            best = edges;
+            for (uint8_t k = 0; k < 4; k++)
+                order[k] = cycle[(cut + k) & 3];
+        }
+    }
+
+    return best;
+}
+
+// Asks the scan engine for the next frame boundary, to swap the buffers or apply the timing.
+void request_swap(void);
+
+// Writes the back buffer from the content, then requests the swap, see build_frame().
+static void build_back_buffer(void)
+{
+    swap  = 0;  // front is stable from here
+    dirty = 0;
+
+    const uint8_t   b     = front ^ 1;
+    uint32_t* const back  = frame.gpioc_bshr[b];
+    uint32_t        masks = (seg_masks & effect_keep) | effect_set;  // One load of the content
+    uint8_t         shown[4];
+    for (uint8_t i = 0; i < 4; i++, masks >>= 8)
+        shown[i] = masks & 0x3F;
+
+    // Frame table index of the HIGH half-phase of COM i, LOW is at + 4 in frame inversion and + 1 otherwise.
+    // With LCD_GRAYSCALE the order is picked on the segments lit at any level, all sub-frames share the COM words.
+    uint8_t slots[4] = {0, 2, 4, 6};
+    uint8_t low      = 1;
+    if (drive_mode != LCD_DRIVE_LINE)
+    {
+        uint8_t order[4] = {0, 1, 2, 3};
+        if (drive_mode == LCD_DRIVE_ORDER)
+            order_coms(shown, order);
+
+        for (uint8_t k = 0; k < 4; k++)
+            slots[order[k]] = k;
+        low = 4;
+    }
+
+    for (uint8_t i = 0; i < 4; i++)
+    {
+        const uint32_t seg_mask = shown[i];
+        const uint8_t  high     = slots[i];
+        const uint8_t  pin      = com_pins[i] & 0x0F;
+
+        frame.gpiod_bshr[b][high]        = 1 << pin;          // COM - High
+        frame.gpiod_bshr[b][high + low]  = 1 << (pin + 16);   // COM - Low
+        frame.gpiod_cfglr[b][high]       = com_cfglr[i];
+        frame.gpiod_cfglr[b][high + low] = com_cfglr[i];
+
+#if LCD_GRAYSCALE
+        // Segments lit at level >= n, n = 0 - 3
+        const uint8_t lit[4] = {
+            seg_mask,
+            seg_mask & (level_planes[0][i] | level_planes[1][i]),
+            seg_mask & level_planes[1][i],
+            seg_mask & level_planes[0][i] & level_planes[1][i],
+        };
+
+        for (uint8_t k = 0; k < LCD_SUBFRAMES; k++)
+        {
+            const uint32_t sub_mask     = lit[subframe_levels[k]];
+            const uint32_t inv_sub_mask = ~sub_mask & 0x3F;
+
+            back[k * 8 + high]       = (sub_mask << 16) | inv_sub_mask;
+            back[k * 8 + high + low] = (inv_sub_mask << 16) | sub_mask;
+        }
+#else
+        const uint32_t inv_seg_mask = ~seg_mask & 0x3F;
+
+        back[high]       = (seg_mask << 16) | inv_seg_mask;  // COM - High, SEG1-6 - Low as required
+        back[high + low] = (inv_seg_mask << 16) | seg_mask;  // COM - Low, SEG1-6 - High as required
+#endif
+    }
+
+    swap = 1;
+    request_swap();
+}
+
+// Rebuilds the back buffer and requests a swap, after the profiler, which times it.
+void build_frame(void);
 
 void calculate_seg_masks(const uint8_t d1_segs, const uint8_t d2_segs, const uint8_t d3_segs)
 {
@@ -85,59 +363,612 @@ void calculate_seg_masks(const uint8_t d1_segs, const uint8_t d2_segs, const uin
     // Segment Mask for COM3 - GB GB GB - 0b0001100 / 0x0C - <<2     >>2
     // Segment Mask for COM4 - FA FA FA - 0b0000011 / 0x03 - <<4 <<2
     //              Segments - 65 43 21
-    seg_masks[0] = ((d1_segs & 0x40) >> 1) | ((d2_segs & 0x40) >> 3) | ((d3_segs & 0x40) >> 5);  // COM1: D  bits
-    seg_masks[1] = ((d1_segs & 0x30) >> 0) | ((d2_segs & 0x30) >> 2) | ((d3_segs & 0x30) >> 4);  // COM2: EC bits
-    seg_masks[2] = ((d1_segs & 0x0C) << 2) | ((d2_segs & 0x0C) >> 0) | ((d3_segs & 0x0C) >> 2);  // COM3: GB bits
-    seg_masks[3] = ((d1_segs & 0x03) << 4) | ((d2_segs & 0x03) << 2) | ((d3_segs & 0x03) >> 0);  // COM4: FA bits
+    const uint32_t com1 = ((d1_segs & 0x40) >> 1) | ((d2_segs & 0x40) >> 3) | ((d3_segs & 0x40) >> 5);  // D  bits
+    const uint32_t com2 = ((d1_segs & 0x30) >> 0) | ((d2_segs & 0x30) >> 2) | ((d3_segs & 0x30) >> 4);  // EC bits
+    const uint32_t com3 = ((d1_segs & 0x0C) << 2) | ((d2_segs & 0x0C) >> 0) | ((d3_segs & 0x0C) >> 2);  // GB bits
+    const uint32_t com4 = ((d1_segs & 0x03) << 4) | ((d2_segs & 0x03) << 2) | ((d3_segs & 0x03) >> 0);  // FA bits
+
+    seg_masks = com1 | (com2 << 8) | (com3 << 16) | (com4 << 24);
+    build_frame();
+}
+
+// Packed COM segment masks, from LCD_MASKS(), lcd_encode() or glyph_com_masks, byte n is COM(n+1).
+void show_masks(const uint32_t masks)
+{
+    seg_masks = masks;
+    build_frame();
+}
+
+// Glyph indexes, GLYPH_0 etc., 3 table lookups instead of the shuffle in calculate_seg_masks().
+void show_glyphs(const uint8_t d1_glyph, const uint8_t d2_glyph, const uint8_t d3_glyph)
+{
+    show_masks(glyph_com_masks[0][d1_glyph] | glyph_com_masks[1][d2_glyph] | glyph_com_masks[2][d3_glyph]);
+}
+
+// Partial update, masks in the 2 SEG bits of one digit across the 4 COM masks, pos 0 - 2 is D1 - D3.
+// Marks the masks dirty only if they changed, call lcd_flush() after one or more digits.
+// A load, modify and store of seg_masks, RV32EC has no atomic instructions, so interrupts are masked for those
+// few instructions, an update from SysTick_Handler in between would be lost.
+void lcd_set_digit(const uint8_t pos, const uint8_t glyph)
+{
+    if (pos > 2 || glyph >= GLYPH_COUNT)
+        return;
+
+    const uint32_t keep  = ~(0x30303030 >> (pos << 1));  // D1 - Bit 5-4, D2 - Bit 3-2, D3 - Bit 1-0 of each COM
+    const uint32_t masks = glyph_com_masks[pos][glyph];
+
+    __disable_irq();
+    const uint32_t old_masks = seg_masks;
+    const uint32_t new_masks = (old_masks & keep) | masks;
+    seg_masks                = new_masks;
+    __enable_irq();
+
+    if (old_masks != new_masks)
+        dirty = 1;
+}
+
+// Rebuild the frame table if a digit changed, otherwise nothing to do.
+void lcd_flush(void)
+{
+    if (dirty)
+        build_frame();
+}
+
+#if LCD_GRAYSCALE
+// Level 0 - 3 of the segments in cells, packed COM masks, e.g. LCD_DIGIT_D1 to dim a field, LCD_ALL for all.
+void lcd_set_level(const uint32_t cells, const uint8_t level)
+{
+    for (uint8_t i = 0; i < 4; i++)
+    {
+        const uint8_t mask = cells >> (i << 3);
+
+        level_planes[0][i] = level & 1 ? level_planes[0][i] | mask : level_planes[0][i] & ~mask;
+        level_planes[1][i] = level & 2 ? level_planes[1][i] | mask : level_planes[1][i] & ~mask;
+    }
+
+    build_frame();
 }
+#endif
 
 void show_hex_number(const uint16_t number)
 {
-    calculate_seg_masks(character_segments[(number >> 8) & 0x0F],  // D1
-                        character_segments[(number >> 4) & 0x0F],  // D2
-                        character_segments[number & 0x0F]);        // D3
+    show_glyphs((number >> 8) & 0x0F,  // D1
+                (number >> 4) & 0x0F,  // D2
+                number & 0x0F);        // D3
+}
+
+// rv32ec has neither a divider nor a multiplier, n / 10 and n * 10 by shifts and adds.
+// n / 10 = n * 205 >> 11, exact for n <= 1028, 205 = 0b11001101
+static inline uint16_t div10(const uint16_t n)
+{
+    const uint32_t x = n;
+    return ((x << 7) + (x << 6) + (x << 3) + (x << 2) + x) >> 11;
+}
+
+static inline uint16_t mul10(const uint16_t n)
+{
+    return (n << 3) + (n << 1);
+}
+
+// 0 - 999, leading zeros blanked, "---" if out of range.
+void show_decimal(const uint16_t number)
+{
+    if (number > 999)
+    {
+        show_glyphs(GLYPH_MINUS, GLYPH_MINUS, GLYPH_MINUS);
+        return;
+    }
+
+    const uint16_t tens     = div10(number);  // number / 10
+    const uint8_t  hundreds = div10(tens);    // number / 100
+    const uint8_t  d2       = tens - mul10(hundreds);
+    const uint8_t  d3       = number - mul10(tens);
+
+    show_glyphs(hundreds ? hundreds : GLYPH_SPACE,  // D1
+                tens ? d2 : GLYPH_SPACE,            // D2
+                d3);                                // D3
+}
+
+// -99 - 999, the minus sign is next to the first digit, "---" if out of range.
+void show_signed_decimal(const int16_t number)
+{
+    if (number >= 0)
+    {
+        show_decimal(number);
+        return;
+    }
+
+    if (number < -99)
+    {
+        show_glyphs(GLYPH_MINUS, GLYPH_MINUS, GLYPH_MINUS);
+        return;
+    }
+
+    const uint16_t value = -number;
+    const uint8_t  tens  = div10(value);
+    const uint8_t  d3    = value - mul10(tens);
+
+    if (tens)
+        show_glyphs(GLYPH_MINUS, tens, d3);
+    else
+        show_glyphs(GLYPH_SPACE, GLYPH_MINUS, d3);
+}
+
+// Character to glyph index, unsupported characters are spaces.
+static uint8_t glyph_of(const char c)
+{
+    return (uint8_t)c < sizeof(ascii_glyphs) ? ascii_glyphs[(uint8_t)c] : GLYPH_SPACE;
+}
+
+// Runtime encoder, packed COM segment masks of the first 3 characters, same as LCD_MASKS() for literals.
+uint32_t lcd_encode(const char* str)
+{
+    uint32_t masks = 0;
+
+    for (uint8_t i = 0; i < 3 && str[i] != '\0'; i++)
+        masks |= glyph_com_masks[i][glyph_of(str[i])];
+
+    return masks;
 }
 
 void show_string(const char* str)
 {
-    uint8_t segs[3] = {0, 0, 0};  // D1 D2 D3
+    uint8_t glyphs[3] = {GLYPH_SPACE, GLYPH_SPACE, GLYPH_SPACE};  // D1 D2 D3
 
     for (uint8_t i = 0; i < 3; i++)
     {
-        char c = str[i];
+        const char c = str[i];
         if (c == '\0')
             break;  // Early termination
 
-        // Convert to lowercase
-        // - SPC -> 0x20      | 0x20 = 0x20      - Unchanged
-        // - 0-9 -> 0x30-0x39 | 0x20 = 0x30-0x39 - Unchanged
-        // - A-Z -> 0x41-0x5A | 0x20 = 0x61-0x7A - Converted to lowercase
-        // - a-z -> 0x61-0x7A | 0x20 = 0x61-0x7A - Unchanged
-        c |= 0x20;
+        glyphs[i] = glyph_of(c);
+    }
 
-        uint8_t index;
-        if (c >= '0' && c <= '9')
-        {
-            index = c - '0';
-        }
-        else if (c >= 'a' && c <= 'z')
+    show_glyphs(glyphs[0], glyphs[1], glyphs[2]);
+}
+
+// Scrolling Text
+//
+// lcd_scroll() encodes the string into glyph indexes once, then scroll_tick() moves it one character every
+// speed x 100ms, from the 100ms tick of SysTick_Handler, or of lcd_standby_phase(), the application never waits.
+// - LCD_SCROLL_WRAP  - Marquee, the end is followed by 3 blanks and the start again.
+// - LCD_SCROLL_PAUSE - Stops with the last 3 characters shown, holds for LCD_SCROLL_HOLD steps, then restarts.
+// Strings of up to 3 characters are shown without scrolling, longer than LCD_SCROLL_MAX are cut.
+#define LCD_SCROLL_WRAP  0
+#define LCD_SCROLL_PAUSE 1
+#define LCD_SCROLL_MAX   32  // Glyphs, including the 3 blanks of LCD_SCROLL_WRAP
+#define LCD_SCROLL_HOLD  10  // Steps
+
+static uint8_t          scroll_glyphs[LCD_SCROLL_MAX];
+static volatile uint8_t scroll_length = 0;  // 0 - Not scrolling
+static uint8_t          scroll_pos    = 0;  // Glyph shown at D1
+static uint8_t          scroll_speed  = 1;  // 100ms ticks per step
+static uint8_t          scroll_ticks  = 0;
+static uint8_t          scroll_hold   = 0;
+static uint8_t          scroll_mode   = LCD_SCROLL_WRAP;
+
+static void scroll_show(void)
+{
+    const uint8_t length = scroll_length;
+    uint8_t       d2     = scroll_pos + 1;
+    uint8_t       d3     = scroll_pos + 2;
+
+    if (d2 >= length)
+        d2 -= length;
+    if (d3 >= length)
+        d3 -= length;
+
+    show_glyphs(scroll_glyphs[scroll_pos], scroll_glyphs[d2], scroll_glyphs[d3]);
+}
+
+void lcd_scroll_stop(void)
+{
+    scroll_length = 0;
+}
+
+void lcd_scroll(const char* str, const uint8_t speed, const uint8_t mode)
+{
+    uint8_t length = 0;
+
+    scroll_length = 0;  // Stop scroll_tick() while the glyphs are rewritten
+
+    while (str[length] != '\0' && length < LCD_SCROLL_MAX - 3)
+    {
+        scroll_glyphs[length] = glyph_of(str[length]);
+        length++;
+    }
+
+    if (length <= 3)
+    {
+        show_string(str);
+        return;
+    }
+
+    if (mode == LCD_SCROLL_WRAP)
+    {
+        scroll_glyphs[length++] = GLYPH_SPACE;
+        scroll_glyphs[length++] = GLYPH_SPACE;
+        scroll_glyphs[length++] = GLYPH_SPACE;
+    }
+
+    scroll_pos    = 0;
+    scroll_speed  = speed ? speed : 1;
+    scroll_ticks  = 0;
+    scroll_hold   = 0;
+    scroll_mode   = mode;
+    scroll_length = length;
+
+    scroll_show();
+}
+
+// Called every 100ms
+static void scroll_tick(void)
+{
+    const uint8_t length = scroll_length;
+
+    if (length == 0 || ++scroll_ticks < scroll_speed)
+        return;
+    scroll_ticks = 0;
+
+    if (scroll_mode == LCD_SCROLL_WRAP)
+    {
+        if (++scroll_pos == length)
+            scroll_pos = 0;
+    }
+    else if (scroll_pos < length - 3)
+        scroll_pos++;
+    else if (++scroll_hold == LCD_SCROLL_HOLD)
+    {
+        scroll_hold = 0;
+        scroll_pos  = 0;
+    }
+    else
+        return;  // Holding, nothing changed
+
+    scroll_show();
+}
+
+// Scan Timing
+// - TIM2 clock = HCLK / (PSC + 1) = 1MHz, update every 2000 ticks = 2ms by default.
+// - 1000ms / (2ms x 8) = 62.5 FPS
+// - Frame rate = 1000000 / (8 x phase_us), set at runtime by lcd_set_timing().
+#define LCD_TIMER_HZ     1000000
+#define LCD_PHASE_US     2000
+#define LCD_PHASE_US_MIN 100  // Leaves the handlers room at 24MHz
+
+static volatile uint16_t phase_us = LCD_PHASE_US;  // Half-phase period
+static volatile uint16_t float_us = 0;             // All-float slot at the end of each half-phase, 0 - off
+static volatile uint8_t  retime   = 0;             // 1 - phase_us or float_us changed, see scan_timing()
+
+// Effects
+//
+// Keyframe tables in flash, stepped from the 100ms tick like scroll_tick(), each step is one keyframe load.
+// A keyframe is an overlay on the content, applied by build_frame(), so the content can still change while
+// an effect plays, e.g. a blinking digit of a counter.
+// - keep - Packed COM masks of the content that stays visible, LCD_DIGIT_D1 etc., LCD_ALL or 0.
+// - set  - Packed COM masks forced on, LCD_SEG_AT() or glyph_com_masks.
+// - dim  - Drive time of each half-phase, phase_us >> dim, the rest is the all-float slot of lcd_set_timing(),
+//          0 - Full. Fades the whole display and keeps DC balance, no effect with the standby scan engine. The slot
+//          of lcd_set_timing() and lcd_set_contrast(), also when set during the effect, comes back after it.
+// - ticks - 100ms ticks to hold the keyframe, 0 ends the table.
+// lcd_count_to() is the count-up transition, a number easing towards a target, one step per tick.
+#define LCD_ALL               0x3F3F3F3F
+#define LCD_DIGIT_D1          0x30303030
+#define LCD_DIGIT_D2          0x0C0C0C0C
+#define LCD_DIGIT_D3          0x03030303
+#define LCD_SEG_AT(pos, segs) (GLYPH_COM_MASKS(segs) >> ((pos) << 1))  // 0bDECGBFA segments at D1 - D3
+
+typedef struct
+{
+    uint32_t keep;
+    uint32_t set;
+    uint8_t  dim;
+    uint8_t  ticks;
+} lcd_keyframe_t;
+
+// Blinks the whole display, 500ms on, 500ms off.
+const lcd_keyframe_t lcd_blink[] = {
+    {LCD_ALL, 0, 0, 5},
+    {0, 0, 0, 5},
+    {0, 0, 0, 0},
+};
+
+// Blinks D3, e.g. the digit being edited, 300ms on, 300ms off.
+const lcd_keyframe_t lcd_blink_d3[] = {
+    {LCD_ALL, 0, 0, 3},
+    {LCD_ALL & ~LCD_DIGIT_D3, 0, 0, 3},
+    {0, 0, 0, 0},
+};
+
+// Busy spinner, one segment chasing around the outline of the 3 digits, 1s per lap.
+const lcd_keyframe_t lcd_spinner[] = {
+    {0, LCD_SEG_AT(0, 0x01), 0, 1},  // A1
+    {0, LCD_SEG_AT(1, 0x01), 0, 1},  // A2
+    {0, LCD_SEG_AT(2, 0x01), 0, 1},  // A3
+    {0, LCD_SEG_AT(2, 0x04), 0, 1},  // B3
+    {0, LCD_SEG_AT(2, 0x10), 0, 1},  // C3
+    {0, LCD_SEG_AT(2, 0x40), 0, 1},  // D3
+    {0, LCD_SEG_AT(1, 0x40), 0, 1},  // D2
+    {0, LCD_SEG_AT(0, 0x40), 0, 1},  // D1
+    {0, LCD_SEG_AT(0, 0x20), 0, 1},  // E1
+    {0, LCD_SEG_AT(0, 0x02), 0, 1},  // F1
+    {0, 0, 0, 0},
+};
+
+// Fades the content out and back in by the drive duty, 100%, 50%, 25%, 12.5%.
+const lcd_keyframe_t lcd_pulse[] = {
+    {LCD_ALL, 0, 0, 4},
+    {LCD_ALL, 0, 1, 1},
+    {LCD_ALL, 0, 2, 1},
+    {LCD_ALL, 0, 3, 2},
+    {LCD_ALL, 0, 2, 1},
+    {LCD_ALL, 0, 1, 1},
+    {0, 0, 0, 0},
+};
+
+void lcd_set_timing(uint16_t new_phase_us, uint16_t new_float_us);
+
+static const lcd_keyframe_t* volatile effect = 0;  // 0 - No effect
+static const lcd_keyframe_t*          effect_frame;
+static uint8_t                        effect_ticks;
+static uint8_t                        effect_repeat;  // Plays left, 0 - Forever
+static uint8_t                        effect_dim;
+static uint16_t                       base_float_us = 0;  // float_us of lcd_set_timing(), dim overrides it
+
+static volatile uint8_t counting = 0;  // 1 - lcd_count_to() running
+static int16_t          count_value;
+static int16_t          count_target;
+
+static void effect_dim_to(const uint8_t dim)
+{
+    if (dim == effect_dim)
+        return;
+
+    effect_dim = dim;
+    lcd_set_timing(phase_us, base_float_us);
+}
+
+static void effect_show(void)
+{
+    effect_keep  = effect_frame->keep;
+    effect_set   = effect_frame->set;
+    effect_ticks = effect_frame->ticks;
+    effect_dim_to(effect_frame->dim);
+    build_frame();
+}
+
+void lcd_effect_stop(void)
+{
+    if (effect == 0)
+        return;
+
+    effect      = 0;
+    effect_keep = 0xFFFFFFFF;
+    effect_set  = 0;
+    effect_dim_to(0);
+    build_frame();
+}
+
+// Plays a keyframe table repeat times, 0 - until lcd_effect_stop() or the next lcd_effect().
+void lcd_effect(const lcd_keyframe_t* table, const uint8_t repeat)
+{
+    lcd_effect_stop();
+
+    if (table == 0 || table->ticks == 0)
+        return;
+
+    effect_repeat = repeat;
+    effect_frame  = table;
+    effect_show();
+    effect = table;
+}
+
+// Counts from from to to, -99 - 999, the step is 1/4 of the distance left, at least 1, so long counts ease out.
+void lcd_count_to(const int16_t from, const int16_t to)
+{
+    counting     = 0;
+    count_value  = from;
+    count_target = to;
+    show_signed_decimal(from);
+    counting = from != to;
+}
+
+// Called every 100ms
+static void effect_tick(void)
+{
+    if (counting)
+    {
+        const int16_t distance = count_target - count_value;
+        int16_t       step     = distance >> 2;
+
+        if (step == 0)
+            step = distance > 0 ? 1 : -1;
+        count_value += step;
+        show_signed_decimal(count_value);
+        if (count_value == count_target)
+            counting = 0;
+    }
+
+    if (effect == 0 || --effect_ticks)
+        return;
+
+    effect_frame++;
+    if (effect_frame->ticks == 0)
+    {
+        if (effect_repeat && --effect_repeat == 0)
         {
-            index = c - 'a' + 10;
+            lcd_effect_stop();
+            return;
         }
-        // segs initialized as spaces
-        // else if (c == ' ')
-        // {
-        //     index = 36;
-        // }
-        else
+        effect_frame = effect;
+    }
+    effect_show();
+}
+
+// Profiler
+//
+// Enabled by LCD_PROFILE in funconfig.h, times the handlers in HCLK cycles with SysTick->CNT, free-running
+// from systick_init(). Send 'p' with minichlink -T to print the statistics over SWIO, 'r' to reset them.
+// - systick - SysTick_Handler, including its frame builds
+// - update  - build_frame(), each frame table build from main() or a handler
+// - scan    - TIM2_IRQHandler half-phase, or DMA1_Channel1_IRQHandler swap
+// - jitter  - |Interval between half-phase entries - phase_us|, IRQ engine only
+//
+// Histogram buckets are powers of 2, <16, <32, ... <1024, >=1024 cycles.
+#if LCD_PROFILE
+#if !FUNCONF_USE_DEBUGPRINTF
+#error LCD_PROFILE prints over SWIO, set FUNCONF_USE_DEBUGPRINTF to 1
+#endif
+#if LCD_SCAN_ENGINE == LCD_SCAN_AWU
+#error LCD_PROFILE needs SysTick, which stops in standby
+#endif
+
+#define PROFILE_BUCKETS 8
+
+enum
+{
+    PROFILE_SYSTICK,
+    PROFILE_UPDATE,
+    PROFILE_SCAN,
+#if LCD_SCAN_ENGINE == LCD_SCAN_IRQ
+    PROFILE_JITTER,
+#endif
+    PROFILE_COUNT
+};
+
+typedef struct
+{
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint32_t total;  // Wraps after 2^32 cycles of handler time, hours at these rates
+    uint16_t histogram[PROFILE_BUCKETS];
+} lcd_profile_t;
+
+static const char* const profile_names[PROFILE_COUNT] = {
+    "systick",
+    "update",
+    "scan",
+#if LCD_SCAN_ENGINE == LCD_SCAN_IRQ
+    "jitter",
+#endif
+};
+static lcd_profile_t     profiles[PROFILE_COUNT];
+
+#define PROFILE_START()            (SysTick->CNT)
+#define PROFILE_END(probe, start)  profile_record(probe, SysTick->CNT - (start))
+
+static void profile_reset(void)
+{
+    for (uint8_t p = 0; p < PROFILE_COUNT; p++)
+        profiles[p] = (lcd_profile_t){.min = UINT32_MAX};
+}
+
+// Called from the handlers, they don't preempt each other at the default priority, and from build_frame(),
+// which records while it holds building.
+static void profile_record(const uint8_t probe, const uint32_t cycles)
+{
+    lcd_profile_t* p = &profiles[probe];
+    uint8_t        b = 0;
+
+    while (b < PROFILE_BUCKETS - 1 && (cycles >> (b + 4)))
+        b++;
+
+    p->count++;
+    p->total += cycles;
+    if (cycles < p->min)
+        p->min = cycles;
+    if (cycles > p->max)
+        p->max = cycles;
+    if (p->histogram[b] != UINT16_MAX)
+        p->histogram[b]++;
+}
+
+#if LCD_SCAN_ENGINE == LCD_SCAN_IRQ
+// Latency of the half-phase entry against the ideal 2ms grid, set by interrupts of equal or higher priority.
+static void profile_phase_entry(const uint32_t now)
+{
+    static uint32_t last = 0;
+    const uint32_t  expected = FUNCONF_SYSTEM_CORE_CLOCK / 1000000 * phase_us;
+    const uint32_t  interval = now - last;
+
+    if (last)
+        profile_record(PROFILE_JITTER, interval > expected ? interval - expected : expected - interval);
+    last = now;
+}
+#endif
+
+static void profile_print(void)
+{
+    lcd_profile_t snapshot[PROFILE_COUNT];
+
+    __disable_irq();
+    for (uint8_t p = 0; p < PROFILE_COUNT; p++)
+        snapshot[p] = profiles[p];
+    __enable_irq();
+
+    printf("  probe    count    min    max   mean    <16    <32    <64   <128   <256   <512  <1024 >=1024\n");
+    for (uint8_t p = 0; p < PROFILE_COUNT; p++)
+    {
+        const lcd_profile_t* s = &snapshot[p];
+        printf("%7s %8lu %6lu %6lu %6lu", profile_names[p], (unsigned long)s->count,
+               (unsigned long)(s->count ? s->min : 0), (unsigned long)s->max,
+               (unsigned long)(s->count ? s->total / s->count : 0));
+        for (uint8_t b = 0; b < PROFILE_BUCKETS; b++)
+            printf(" %6u", s->histogram[b]);
+        printf("\n");
+    }
+}
+
+// Called by poll_input() from main(), overrides the weak handler in ch32fun.c.
+void handle_debug_input(int numbytes, uint8_t* data)
+{
+    for (int i = 0; i < numbytes; i++)
+    {
+        if (data[i] == 'p')
+            profile_print();
+        else if (data[i] == 'r')
         {
-            continue;
+            __disable_irq();
+            profile_reset();
+            __enable_irq();
         }
+    }
+}
+#else
+#define PROFILE_START()            0
+#define PROFILE_END(probe, start)  ((void)(start))
+#endif
+
+static volatile uint8_t building = 0;  // 1 - build_back_buffer() is running, in main() or an interrupt
+static volatile uint8_t rebuild  = 0;  // 1 - An interrupt asked for a build while one was running
 
-        segs[i] = character_segments[index];
+// The frame table changes with the content and drive_mode, rebuild it in calculate_seg_masks().
+// Never blocks the scan engine, a swap still pending is withdrawn and its buffer rewritten.
+//
+// Called from main() and from SysTick_Handler, but the back buffer has only one writer at a time. A build
+// interrupting another one only leaves rebuild set, and the interrupted build runs again with the new content
+// once it is done. Interrupts always run to the end, so an interrupt that finds building clear finishes its
+// own build before main() continues. No interrupts are masked for the build.
+// Profiled as update, from main() including the interrupts that preempt it.
+void build_frame(void)
+{
+    if (building)
+    {
+        rebuild = 1;
+        return;
     }
 
-    calculate_seg_masks(segs[0], segs[1], segs[2]);
+    do
+    {
+        const uint32_t start = PROFILE_START();
+
+        building = 1;
+        rebuild  = 0;
+        build_back_buffer();
+        PROFILE_END(PROFILE_UPDATE, start);  // Before building is cleared, so no other build records meanwhile
+        building = 0;
+    } while (rebuild);
 }
 
 void systick_init(void)
@@ -149,27 +980,425 @@ void systick_init(void)
     SysTick->CTLR = SYSTICK_CTLR_STE | SYSTICK_CTLR_STIE | SYSTICK_CTLR_STCLK;
 }
 
-void SysTick_Handler(void) __attribute__((interrupt));
-void SysTick_Handler(void)
+// Called every 100ms
+void update_display(void)
 {
     // LCDReady  3  2  1  0 Go
     // 01234567890123456789012
-    static char*   startup = "LCDReady  3  2  1  0 Go";
-    static int16_t counter = -64;
-
-    SysTick->CMP += FUNCONF_SYSTEM_CORE_CLOCK / 1000 * 100;  // 100ms
-    SysTick->SR = 0;
+    static const char* startup = "LCDReady  3  2  1  0 Go";
+    static int16_t     counter = -64;
 
     ++counter;
-    if (counter < 0)
-        show_string(&startup[((counter + 64) >> 3) * 3]);
-    else
+    if (counter == -63)
+        lcd_scroll(startup, 3, LCD_SCROLL_PAUSE);  // 20 steps x 300ms to " Go"
+    else if (counter >= 0)
     {
+        if (counter == 0)
+            lcd_scroll_stop();
+
         counter &= 0xFFF;
         show_hex_number(counter);
     }
 }
 
+void SysTick_Handler(void) __attribute__((interrupt));
+void SysTick_Handler(void)
+{
+    const uint32_t start = PROFILE_START();
+
+    SysTick->CMP += FUNCONF_SYSTEM_CORE_CLOCK / 1000 * 100;  // 100ms
+    SysTick->SR = 0;
+
+    scroll_tick();
+    effect_tick();
+    update_display();
+
+    PROFILE_END(PROFILE_SYSTICK, start);
+}
+
+// Scan Engine
+//
+// Steps through 8 half-phases, COM1-4 x HIGH/LOW, selected by LCD_SCAN_ENGINE in funconfig.h.
+// - LCD_SCAN_IRQ - TIM2 update interrupt writes the frame table.
+// - LCD_SCAN_DMA - TIM2 events trigger DMA1 to write the frame table.
+// - LCD_SCAN_AWU - main() writes the frame table, the chip is in standby between half-phases.
+
+#if LCD_SCAN_ENGINE == LCD_SCAN_DMA
+static void dma_channel_init(DMA_Channel_TypeDef* channel, volatile uint32_t* reg, const uint32_t* words,
+                             const uint16_t count)
+{
+    channel->CFGR  = 0;
+    channel->PADDR = (uint32_t)reg;
+    channel->MADDR = (uint32_t)words;
+    channel->CNTR  = count;
+    channel->CFGR  = DMA_CFGR1_DIR | DMA_CFGR1_CIRC | DMA_CFGR1_MINC |  // Memory -> Peripheral, circular
+                    DMA_CFGR1_PSIZE_1 | DMA_CFGR1_MSIZE_1 |            // 32-bit -> 32-bit
+                    DMA_CFGR1_PL_1 | DMA_CFGR1_EN;                     // High priority
+}
+
+// Period and all-float compare, preloaded, so they take effect at the next update. Applied by lcd_start(), then
+// only in the swap interrupt, which runs in the last half-phase of the frame, so every half-phase of the next
+// frame has the new timing and both half-phases of a COM match. CC2 DMA stays enabled, without the slot its
+// compare is past ATRLR and never matches.
+static void scan_timing(void)
+{
+    retime       = 0;
+    TIM2->ATRLR  = phase_us - 1;
+    TIM2->CH2CVR = phase_us - float_us;
+}
+
+// Swap in DMA1 Channel1 transfer complete interrupt, enabled only while a swap or a timing change is pending.
+// The GPIOC->BSHR word of the last half-phase is the last write of a frame, the next one is 2ms away.
+// With LCD_GRAYSCALE, Channel1 streams all sub-frames, the COM channels repeat their 8 words in step.
+//
+// The streams never wait for the CPU, only the swap does. Run late by a critical section of the application,
+// the next frame has already started, restarting the streams would put the SEG words out of step with the COM
+// words. The swap then waits for the end of that frame. All 3 channels have a full count only before the
+// first word of a frame, the update of the next frame fires Channel2 one tick before Channel5 and Channel1.
+#define LCD_SWAP_MARGIN_US 8  // Restart the streams at least this long before the next TIM2 update
+
+void request_swap(void)
+{
+    DMA1_Channel1->CFGR |= DMA_CFGR1_TCIE;
+}
+
+void DMA1_Channel1_IRQHandler(void) __attribute__((interrupt));
+void DMA1_Channel1_IRQHandler(void)
+{
+    const uint32_t start = PROFILE_START();
+
+    DMA1->INTFCR = DMA_CTCIF1;
+
+    if ((swap || retime) && (DMA1_Channel1->CNTR != LCD_SEG_WORDS || DMA1_Channel2->CNTR != 8 ||
+                             DMA1_Channel5->CNTR != 8 || TIM2->CNT > TIM2->ATRLR - LCD_SWAP_MARGIN_US))
+    {
+        PROFILE_END(PROFILE_SCAN, start);
+        return;  // Too late for this frame boundary, keep TCIE for the next one
+    }
+
+    const uint32_t cfgr = DMA1_Channel1->CFGR & ~DMA_CFGR1_TCIE;
+    if (swap)
+    {
+        front ^= 1;
+        swap = 0;
+
+        // The COM channels have wrapped at the same boundary, restart all 3 streams on the new buffer
+        const uint32_t cfgr2 = DMA1_Channel2->CFGR;
+        const uint32_t cfgr5 = DMA1_Channel5->CFGR;
+
+        DMA1_Channel2->CFGR  = cfgr2 & ~DMA_CFGR1_EN;
+        DMA1_Channel2->MADDR = (uint32_t)frame.gpiod_bshr[front];
+        DMA1_Channel2->CNTR  = 8;
+        DMA1_Channel2->CFGR  = cfgr2;
+
+        DMA1_Channel5->CFGR  = cfgr5 & ~DMA_CFGR1_EN;
+        DMA1_Channel5->MADDR = (uint32_t)frame.gpiod_cfglr[front];
+        DMA1_Channel5->CNTR  = 8;
+        DMA1_Channel5->CFGR  = cfgr5;
+
+        DMA1_Channel1->CFGR  = cfgr & ~DMA_CFGR1_EN;
+        DMA1_Channel1->MADDR = (uint32_t)frame.gpioc_bshr[front];
+        DMA1_Channel1->CNTR  = LCD_SEG_WORDS;
+    }
+    if (retime)
+        scan_timing();
+    DMA1_Channel1->CFGR = cfgr;
+
+    PROFILE_END(PROFILE_SCAN, start);
+}
+
+void lcd_start(void)
+{
+    RCC->AHBPCENR  |= RCC_AHBPeriph_DMA1;
+    RCC->APB1PCENR |= RCC_APB1Periph_TIM2;
+
+    build_com_words();
+    build_frame();
+    front ^= 1;  // Scan the new buffer right away
+    swap = 0;
+
+    TIM2->CTLR1     = TIM_ARPE;
+    TIM2->DMAINTENR = 0;
+    TIM2->PSC       = FUNCONF_SYSTEM_CORE_CLOCK / LCD_TIMER_HZ - 1;
+    TIM2->CHCTLR1   = TIM_OC2PE;
+    TIM2->CH1CVR    = 1;  // GPIOD->CFGLR 1 tick after GPIOD->BSHR
+    TIM2->CH3CVR    = 1;  // GPIOC->BSHR
+    scan_timing();
+    TIM2->SWEVGR = TIM_UG;        // Load PSC, ATRLR and CH2CVR
+    TIM2->CNT    = phase_us - 1;  // Update first, keep the streams in step
+
+    dma_channel_init(DMA1_Channel2, &GPIOD->BSHR, frame.gpiod_bshr[front], 8);
+    dma_channel_init(DMA1_Channel5, &GPIOD->CFGLR, frame.gpiod_cfglr[front], 8);
+    dma_channel_init(DMA1_Channel1, &GPIOC->BSHR, frame.gpioc_bshr[front], LCD_SEG_WORDS);
+    dma_channel_init(DMA1_Channel7, &GPIOD->CFGLR, &frame.gpiod_float, 1);
+    NVIC_EnableIRQ(DMA1_Channel1_IRQn);
+
+    TIM2->INTFR = 0;
+    TIM2->DMAINTENR |= TIM_UDE | TIM_CC1DE | TIM_CC2DE | TIM_CC3DE;
+    TIM2->CTLR1 = TIM_ARPE | TIM_CEN;
+}
+
+void lcd_stop(void)
+{
+    TIM2->CTLR1         = 0;
+    TIM2->DMAINTENR     = 0;
+    DMA1_Channel2->CFGR = 0;
+    DMA1_Channel5->CFGR = 0;
+    DMA1_Channel1->CFGR = 0;
+    DMA1_Channel7->CFGR = 0;
+    NVIC_DisableIRQ(DMA1_Channel1_IRQn);
+
+    GPIOD->CFGLR = (GPIOD->CFGLR & 0xF000FFF0) | 0x04440004;  // Set PD0, PD4, PD5, PD6 to floating input
+    GPIOC->BSHR  = 0x3F << 16;                                // Set PC0-PC5 to LOW
+}
+#elif LCD_SCAN_ENGINE == LCD_SCAN_AWU
+// Standby between half-phases, woken by the AWU event.
+// - AWU clock = LSI 128kHz / 32 = 4kHz, window 8 = 2ms, phase_us is rounded down to 250us steps, 250us - 15.75ms.
+// - GPIO keeps its state in standby, the driven COM and SEG1-6 hold the half-phase while the chip sleeps,
+//   the other COMs float on the external divider.
+// - SysTick stops in standby, update_display() is called every 100ms worth of half-phases instead.
+// - No all-float slot, it would take a second wake-up per half-phase.
+#define LCD_AWU_TICK_US 250
+#define LCD_UPDATE_US   100000
+
+static uint8_t  phase  = 0;  // Frame table index, Bit 4-3: Sub-frame, Bit 2-0: Half-phase, see drive_mode
+static uint16_t awu_us = 0;  // Programmed AWU window in us, the real half-phase period
+
+// AWU window in 250us ticks, counted down, no divider on rv32ec. Applied by lcd_start(), then only at the
+// frame boundary, so both half-phases of a COM have the same period.
+static void scan_timing(void)
+{
+    uint8_t window = 0;
+    retime = 0;
+    for (uint16_t us = phase_us; us >= LCD_AWU_TICK_US && window < 63; us -= LCD_AWU_TICK_US)
+        window++;
+    if (!window)
+        window = 1;
+
+    PWR->AWUWR = window;
+    awu_us     = (window << 8) - (window << 2) - (window << 1);  // window x 250, no multiplier on rv32ec
+}
+
+// Swap in lcd_standby_phase() at the first half-phase.
+void request_swap(void) {}
+
+void lcd_start(void)
+{
+    RCC->APB1PCENR |= RCC_APB1Periph_PWR;
+    RCC->RSTSCKR |= RCC_LSION;
+    while ((RCC->RSTSCKR & RCC_LSIRDY) == 0) {}
+
+    build_com_words();
+    build_frame();
+    front ^= 1;  // Scan the new buffer right away
+    swap  = 0;
+    phase = 0;
+
+    EXTI->EVENR |= EXTI_Line9;  // AWU wakes the chip with an event on EXTI line 9
+    EXTI->FTENR |= EXTI_Line9;
+
+    PWR->AWUPSC = PWR_AWU_Prescaler_32;
+    scan_timing();
+    PWR->AWUCSR = PWR_AWUCSR_AWUEN;
+    PWR->CTLR |= PWR_CTLR_PDDS;  // Standby on deep sleep
+}
+
+// Undoes lcd_start(), so a later deep sleep of the application is stop again, not standby. LSI and the PWR
+// clock stay on, the application may use them.
+void lcd_stop(void)
+{
+    PWR->AWUCSR = 0;
+    PWR->CTLR &= ~PWR_CTLR_PDDS;
+    EXTI->EVENR &= ~EXTI_Line9;
+    EXTI->FTENR &= ~EXTI_Line9;
+
+    GPIOD->CFGLR = (GPIOD->CFGLR & 0xF000FFF0) | 0x04440004;  // Set PD0, PD4, PD5, PD6 to floating input
+    GPIOC->BSHR  = 0x3F << 16;                                // Set PC0-PC5 to LOW
+}
+
+// Write one half-phase, then standby until the next AWU event. Call it from the main loop.
+void lcd_standby_phase(void)
+{
+    static uint32_t elapsed_us = 0;
+
+    const uint8_t i = phase;
+
+    // Frame boundary - swap to the new content, and the window of the new timing
+    if (i == 0 && swap)
+    {
+        front ^= 1;
+        swap = 0;
+    }
+    if (i == 0 && retime)
+        scan_timing();
+
+    const uint8_t f = front;
+    GPIOD->BSHR  = frame.gpiod_bshr[f][i & 7];
+    GPIOD->CFGLR = frame.gpiod_cfglr[f][i & 7];
+    GPIOC->BSHR  = frame.gpioc_bshr[f][i];
+
+    phase = (i + 1) & (LCD_SEG_WORDS - 1);
+
+    elapsed_us += awu_us;  // Rounded and clamped like the AWU, so the 100ms tick does not drift
+    if (elapsed_us >= LCD_UPDATE_US)
+    {
+        elapsed_us -= LCD_UPDATE_US;
+        scroll_tick();
+        effect_tick();
+        update_display();
+    }
+
+    PFIC->SCTLR |= (1 << 2);  // SLEEPDEEP
+    __WFE();
+    PFIC->SCTLR &= ~(1 << 2);
+}
+#else
+static volatile uint8_t phase = 0;  // Frame table index, Bit 4-3: Sub-frame, Bit 2-0: Half-phase, see drive_mode
+
+// Swap in TIM2_IRQHandler at the first half-phase.
+void request_swap(void) {}
+
+// Period and all-float compare, preloaded, so they take effect at the next update. Applied by lcd_start(), then
+// only in the last half-phase of the frame, so every half-phase of the next frame has the new timing and both
+// half-phases of a COM match. CC2 stays enabled, without the slot its compare is past ATRLR and never matches.
+static void scan_timing(void)
+{
+    retime       = 0;
+    TIM2->ATRLR  = phase_us - 1;
+    TIM2->CH2CVR = phase_us - float_us;
+}
+
+void lcd_start(void)
+{
+    RCC->APB1PCENR |= RCC_APB1Periph_TIM2;
+
+    build_com_words();
+    build_frame();
+    front ^= 1;  // Scan the new buffer right away
+    swap = 0;
+
+    phase           = 0;
+    TIM2->CTLR1     = TIM_ARPE;
+    TIM2->DMAINTENR = 0;
+    TIM2->PSC       = FUNCONF_SYSTEM_CORE_CLOCK / LCD_TIMER_HZ - 1;
+    TIM2->CHCTLR1   = TIM_OC2PE;
+    scan_timing();
+    TIM2->CNT    = 0;
+    TIM2->SWEVGR = TIM_UG;  // Load PSC, ATRLR and CH2CVR
+    TIM2->INTFR  = 0;       // UG sets UIF, clear it before enabling the interrupt
+    TIM2->DMAINTENR |= TIM_UIE | TIM_CC2IE;
+    NVIC_EnableIRQ(TIM2_IRQn);
+    TIM2->CTLR1 = TIM_ARPE | TIM_CEN;
+}
+
+void lcd_stop(void)
+{
+    TIM2->CTLR1     = 0;
+    TIM2->DMAINTENR = 0;
+    NVIC_DisableIRQ(TIM2_IRQn);
+
+    GPIOD->CFGLR = (GPIOD->CFGLR & 0xF000FFF0) | 0x04440004;  // Set PD0, PD4, PD5, PD6 to floating input
+    GPIOC->BSHR  = 0x3F << 16;                                // Set PC0-PC5 to LOW
+}
+
+void TIM2_IRQHandler(void) __attribute__((interrupt));
+void TIM2_IRQHandler(void)
+{
+    const uint32_t start = PROFILE_START();
+
+    // All-float slot at the end of the half-phase, CC2 only matches with float_us set.
+    if (TIM2->INTFR & TIM_CC2IF)
+    {
+        TIM2->INTFR  = (uint16_t)~TIM_CC2IF;
+        GPIOD->CFGLR = frame.gpiod_float;
+        return;
+    }
+
+#if LCD_PROFILE
+    profile_phase_entry(start);
+#endif
+
+    TIM2->INTFR = (uint16_t)~TIM_UIF;
+
+    const uint8_t i = phase;
+
+    // Frame boundary - swap to the new content
+    if (i == 0 && swap)
+    {
+        front ^= 1;
+        swap = 0;
+    }
+
+    // Straight-line stores, the previous COM floats with the new GPIOD->CFGLR word.
+    const uint8_t f = front;
+    GPIOD->BSHR  = frame.gpiod_bshr[f][i & 7];
+    GPIOD->CFGLR = frame.gpiod_cfglr[f][i & 7];
+    GPIOC->BSHR  = frame.gpioc_bshr[f][i];
+
+    // Last half-phase - the preloaded timing starts with the next frame
+    if (retime && i == LCD_SEG_WORDS - 1)
+        scan_timing();
+
+    phase = (i + 1) & (LCD_SEG_WORDS - 1);
+
+    PROFILE_END(PROFILE_SCAN, start);
+}
+#endif
+
+// Half-phase period and the all-float slot at its end, in us, from the next frame on.
+// - Frame rate = 1000000 / (8 x phase_us), e.g. 4000 - 31.25 FPS, 2000 - 62.5 FPS, 1250 - 100 FPS.
+// - In the slot all COMs float at V/2, every cell sees +-V/2 whether lit or not. Lit cells lose RMS voltage,
+//   the contrast drops, the COM drivers rest.
+// - The scan engine applies the change at the frame boundary, like the buffer swap, so both half-phases of a
+//   COM get the same period and slot and DC balance holds, whenever it is called.
+// - A dim keyframe replaces the slot while it is shown, new_float_us is kept and comes back after it.
+void lcd_set_timing(uint16_t new_phase_us, uint16_t new_float_us)
+{
+    if (new_phase_us < LCD_PHASE_US_MIN)
+        new_phase_us = LCD_PHASE_US_MIN;
+    base_float_us = new_float_us;
+    if (effect_dim)
+        new_float_us = new_phase_us - (new_phase_us >> effect_dim);
+    if (new_float_us > new_phase_us - 2)
+        new_float_us = new_phase_us - 2;  // COM and SEG words land on tick 0 and 1
+
+    retime   = 0;  // Never applied half written
+    phase_us = new_phase_us;
+    float_us = new_float_us;
+    retime   = 1;
+    request_swap();
+}
+
+// Contrast 1 - 16, the COM drive time is level / 16 of each half-phase, the rest is the all-float slot.
+// - Applied at the frame boundary like lcd_set_timing(), DC balance holds. Applies to the last phase_us, set it
+//   after lcd_set_timing(), which sets float_us directly.
+// - No all-float slot with the standby scan engine, the contrast stays at 16.
+#define LCD_CONTRAST_MAX 16
+
+void lcd_set_contrast(uint8_t level)
+{
+    if (level == 0)
+        level = 1;  // All-float would blank the panel and leave the COM words with no time to land
+    if (level > LCD_CONTRAST_MAX)
+        level = LCD_CONTRAST_MAX;
+
+    // drive = phase_us x level / 16, by shifts and adds, no multiplier on rv32ec
+    const uint16_t period = phase_us;
+    uint16_t       drive  = level & 16 ? period : 0;
+    for (uint8_t bit = 0; bit < 4; bit++)
+        if (level & (1 << bit))
+            drive += period >> (4 - bit);
+
+    lcd_set_timing(period, period - drive);
+}
+
+// LCD_DRIVE_LINE, LCD_DRIVE_FRAME or LCD_DRIVE_ORDER, the new table is swapped in at the frame boundary.
+void lcd_set_drive(const uint8_t mode)
+{
+    drive_mode = mode;
+    build_frame();
+}
+
 int main(void)
 {
     SystemInit();
@@ -196,32 +1425,31 @@ int main(void)
     GPIOC->CFGLR = (GPIOC->CFGLR & 0xFF000000) | 0x00222222;  // Set PC0-PC5 to 2MHz push-pull output
     GPIOC->BSHR  = 0x3F << 16;                                // Set PC0-PC5 to LOW
 
+#if LCD_SCAN_ENGINE != LCD_SCAN_AWU
     systick_init();
+#endif
+#if LCD_PROFILE
+    profile_reset();
+#endif
+    lcd_start();
 
     while (1)
     {
-        // 1000ms / (4ms x 4) = 62.5 FPS
-        for (uint8_t i = 0; i < 4; i++)
-        {
-            const uint8_t com_pin      = com_pins[i];
-            const uint8_t seg_mask     = seg_masks[i];
-            const uint8_t inv_seg_mask = ~seg_mask & 0x3F;  // Keep lower 6 bits for PC5-PC0
+#if LCD_SCAN_ENGINE == LCD_SCAN_AWU
+        // The LCD is refreshed from main(), application work fits between half-phases.
+        lcd_standby_phase();
+#else
+        // The LCD is refreshed by TIM2 in the background, main() is free for application work.
+#endif
 
-            // COM - Output
-            funPinMode(com_pin, GPIO_Speed_2MHz | GPIO_CNF_OUT_PP);
+#if LCD_PROFILE
+        poll_input();  // Profiler commands from minichlink -T
+#endif
 
-            // COM - High, SEG1-6 - Low as required
-            funDigitalWrite(com_pin, FUN_HIGH);
-            GPIOC->BSHR = (seg_mask << 16) | inv_seg_mask;
-            Delay_Ms(2);
-
-            // COM - Low, SEG1-6 - High as required
-            funDigitalWrite(com_pin, FUN_LOW);
-            GPIOC->BSHR = (inv_seg_mask << 16) | seg_mask;
-            Delay_Ms(2);
-
-            // COM - Float
-            funPinMode(com_pin, GPIO_CNF_IN_FLOATING);
-        }
+#if LCD_SLEEP_WFI && LCD_SCAN_ENGINE != LCD_SCAN_AWU
+        // Sleep until the next interrupt, the next half-phase edge at the latest.
+        // Sleep mode (SLEEPDEEP = 0) keeps HCLK, TIM2, DMA1 and SysTick running.
+        __WFI();
+#endif
     }
 }
@@ -0,0 +1,35 @@
+/*
+ * CH32V003 Segment LCD - Benchmark Firmware
+ *
+ * Builds lcd.c for rv32ec with the IRQ scan engine, the one with a per-phase CPU body.
+ * No startup code, rv32ec_iss loads the ELF and calls the functions listed in sim/Makefile one by one.
+ */
+
+#include "../funconfig.h"
+
+#undef LCD_SCAN_ENGINE
+#define LCD_SCAN_ENGINE LCD_SCAN_IRQ
+
+#define main lcd_main
+#include "../lcd.c"
+#undef main
+
+void SystemInit(void) {}
+
+const char bench_text[] = "lcd";
+
+// show_decimal() as it would be written with a divider, libgcc __udivsi3 and __umodsi3 on rv32ec.
+void naive_decimal(const uint16_t number)
+{
+    if (number > 999)
+    {
+        show_glyphs(GLYPH_MINUS, GLYPH_MINUS, GLYPH_MINUS);
+        return;
+    }
+
+    const uint8_t d1 = number / 100;
+    const uint8_t d2 = number / 10 % 10;
+    const uint8_t d3 = number % 10;
+
+    show_glyphs(number < 100 ? GLYPH_SPACE : d1, number < 10 ? GLYPH_SPACE : d2, d3);
+}
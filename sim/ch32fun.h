@@ -0,0 +1,84 @@
+/*
+ * CH32V003 Segment LCD - Host Simulator
+ *
+ * Mock of ch32fun.h, included by lcd.c instead of ch32fun/ch32fun.h when built on the host.
+ *
+ * The real ch32fun.h provides the register layouts, bit definitions and pin numbers, then the
+ * peripheral pointers are redirected to a register file in host RAM, see lcd_sim.c.
+ * Functions that touch the hardware directly (NVIC, WFI, WFE) are replaced by simulator hooks.
+ */
+
+#ifndef _SIM_CH32FUN_H
+#define _SIM_CH32FUN_H
+
+#include "../ch32fun/ch32fun.h"
+
+// Register File
+extern GPIO_TypeDef        sim_gpioc;
+extern GPIO_TypeDef        sim_gpiod;
+extern TIM_TypeDef         sim_tim2;
+extern DMA_TypeDef         sim_dma1;
+extern DMA_Channel_TypeDef sim_dma1_channels[7];
+extern PWR_TypeDef         sim_pwr;
+extern RCC_TypeDef         sim_rcc;
+extern EXTI_TypeDef        sim_exti;
+extern SysTick_Type        sim_systick;
+extern PFIC_Type           sim_pfic;
+
+#undef GPIOC
+#undef GPIOD
+#undef TIM2
+#undef DMA1
+#undef DMA1_Channel1
+#undef DMA1_Channel2
+#undef DMA1_Channel3
+#undef DMA1_Channel4
+#undef DMA1_Channel5
+#undef DMA1_Channel6
+#undef DMA1_Channel7
+#undef PWR
+#undef RCC
+#undef EXTI
+#undef SysTick
+#undef PFIC
+#undef NVIC
+#undef GpioOf
+
+#define GPIOC         (&sim_gpioc)
+#define GPIOD         (&sim_gpiod)
+#define TIM2          (&sim_tim2)
+#define DMA1          (&sim_dma1)
+#define DMA1_Channel1 (&sim_dma1_channels[0])
+#define DMA1_Channel2 (&sim_dma1_channels[1])
+#define DMA1_Channel3 (&sim_dma1_channels[2])
+#define DMA1_Channel4 (&sim_dma1_channels[3])
+#define DMA1_Channel5 (&sim_dma1_channels[4])
+#define DMA1_Channel6 (&sim_dma1_channels[5])
+#define DMA1_Channel7 (&sim_dma1_channels[6])
+#define PWR           (&sim_pwr)
+#define RCC           (&sim_rcc)
+#define EXTI          (&sim_exti)
+#define SysTick       (&sim_systick)
+#define PFIC          (&sim_pfic)
+#define NVIC          PFIC
+#define GpioOf(pin)   (((pin) >> 4) == 2 ? &sim_gpioc : &sim_gpiod)
+
+// Simulator Hooks
+void sim_nvic_enable(IRQn_Type irq);
+void sim_nvic_disable(IRQn_Type irq);
+void sim_wfi(void);
+void sim_wfe(void);
+
+#define NVIC_EnableIRQ(irq)  sim_nvic_enable(irq)
+#define NVIC_DisableIRQ(irq) sim_nvic_disable(irq)
+#define __WFI()              sim_wfi()
+#define __WFE()              sim_wfe()
+
+// Handlers only run while main() sleeps, nothing to mask.
+#define __disable_irq()
+#define __enable_irq()
+
+// Interrupt handlers are plain functions called by the simulator.
+#define interrupt used
+
+#endif
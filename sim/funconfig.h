@@ -0,0 +1,22 @@
+/*
+ * CH32V003 Segment LCD - Host Simulator
+ *
+ * Wraps the project funconfig.h with the settings the simulator needs.
+ */
+
+#ifndef _SIM_FUNCONFIG_H
+#define _SIM_FUNCONFIG_H
+
+#include "../funconfig.h"
+
+// The simulator advances time when main() sleeps.
+#undef LCD_SLEEP_WFI
+#define LCD_SLEEP_WFI 1
+
+// make SCAN=LCD_SCAN_DMA
+#ifdef SIM_SCAN_ENGINE
+#undef LCD_SCAN_ENGINE
+#define LCD_SCAN_ENGINE SIM_SCAN_ENGINE
+#endif
+
+#endif
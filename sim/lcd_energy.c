@@ -0,0 +1,261 @@
+/*
+ * CH32V003 Segment LCD - Energy Estimator
+ *
+ * Estimates the supply energy of the display from pin-transition traces of lcd_sim -o, in µJ per frame and as
+ * average current, one row per trace and the mean over all of them, so a corpus of contents can be compared
+ * across drive schemes, frame rates and sleep modes.
+ * - Panel    - each of the 24 segment cells is a capacitor between its COM and SEG pin. Every step of the cell
+ *              voltage, through a pin or the COM divider, dissipates C x dV^2 / 2 whichever the direction, and
+ *              over whole frames the supply delivers what is dissipated.
+ * - Dividers - each COM has a resistor R to VDD and one to GND. Floating, VDD / 2R flows through both, driven,
+ *              the pin shorts one of them and VDD / R flows through the other.
+ * - MCU      - the sleep mode current between wake-ups, the run current for each wake-up. The sleep mode and the
+ *              wake-ups come from the trace, the currents are typical figures, use -i and -a for a measured board.
+ *
+ * Trace format, see lcd_verify.c, with the comment lines of lcd_sim
+ *   # sleep=sleep      - WFI with HCLK running, or standby for the AWU scan engine
+ *   # content=888      - Shown text, or demo
+ *   # wakeups=254      - Interrupt entries and AWU events
+ *   # end=12000000     - Last simulated cycle
+ *
+ * Frames are counted at each COM1 HIGH half-phase, from the first driven COM to the end of the simulation.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define PIN_COUNT 10
+
+// MCU at 24MHz HSI and 3.0V
+typedef struct
+{
+    const char* name;
+    double      ma;       // Current between wake-ups
+    double      wake_us;  // Run time per wake-up
+} sleep_mode_t;
+
+#define MODE_RUN     0
+#define MODE_SLEEP   1
+#define MODE_STANDBY 2
+
+static sleep_mode_t modes[3] = {
+    {"run", 2.5, 0},        // Busy-wait, no wake-ups
+    {"sleep", 1.2, 2},      // WFI, half-phase interrupt with entry and exit, an estimate
+    {"standby", 0.01, 35},  // WFE standby with LSI and AWU, wake-up and half-phase
+};
+
+static double vdd      = 3.0;
+static double cell_pf  = 100;  // Per segment cell
+static double div_kohm = 100;  // Per resistor, 2 per COM
+static int    mode_opt = -1;   // From the trace
+
+typedef struct
+{
+    char     content[32];
+    int      mode;
+    uint32_t frames;
+    double   seconds;
+    double   panel_uj;
+    double   divider_uj;
+    double   mcu_uj;
+} estimate_t;
+
+// Energy of one trace, 0 if it has no frame
+static int estimate(const char* path, estimate_t* e)
+{
+    FILE* f = fopen(path, "r");
+    if (!f)
+    {
+        perror(path);
+        exit(2);
+    }
+
+    char               line[256];
+    uint32_t           hclk_hz   = 24000000;
+    uint32_t           wakeups   = 0;
+    unsigned long long end       = 0;
+    char               sleep[16] = "sleep";
+    uint8_t            levels[PIN_COUNT];
+    uint64_t           first    = 0;
+    uint64_t           since    = 0;
+    int                active   = 0;
+    double             cell_sq  = 0;  // Sum of dV^2 over all cell steps, in (V/2)^2
+    uint64_t           floating = 0;  // COM x cycles
+    uint64_t           driven   = 0;
+
+    memset(e, 0, sizeof(*e));
+    strcpy(e->content, "?");
+
+    while (fgets(line, sizeof(line), f))
+    {
+        if (line[0] == '#')
+        {
+            sscanf(line, "# hclk_hz=%u", &hclk_hz);
+            sscanf(line, "# sleep=%15s", sleep);
+            sscanf(line, "# content=%31[^\n]", e->content);
+            sscanf(line, "# wakeups=%u", &wakeups);
+            sscanf(line, "# end=%llu", &end);
+            continue;
+        }
+        if (line[0] < '0' || line[0] > '9')
+            continue;  // Header
+
+        unsigned long long cycle;
+        unsigned           l[PIN_COUNT];
+        if (sscanf(line, "%llu,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u", &cycle, &l[0], &l[1], &l[2], &l[3], &l[4], &l[5], &l[6],
+                   &l[7], &l[8], &l[9]) != PIN_COUNT + 1)
+        {
+            fprintf(stderr, "Bad trace line: %s", line);
+            exit(2);
+        }
+
+        if (active)
+        {
+            for (int c = 0; c < 4; c++)
+            {
+                *(levels[c] == 1 ? &floating : &driven) += cycle - since;
+
+                for (int s = 0; s < 6; s++)
+                {
+                    const int dv = ((int)l[4 + s] - (int)l[c]) - ((int)levels[4 + s] - (int)levels[c]);
+                    cell_sq += dv * dv;
+                }
+            }
+            e->frames += l[0] == 2 && levels[0] != 2;
+        }
+
+        for (int i = 0; i < PIN_COUNT; i++)
+            levels[i] = l[i];
+        since = cycle;
+
+        if (!active && (levels[0] != 1 || levels[1] != 1 || levels[2] != 1 || levels[3] != 1))
+        {
+            active = 1;
+            first  = cycle;
+            e->frames += levels[0] == 2;
+        }
+    }
+    fclose(f);
+
+    if (!active || e->frames == 0)
+        return 0;
+
+    // Levels held to the end of the simulation
+    if (end > since)
+        for (int c = 0; c < 4; c++)
+            *(levels[c] == 1 ? &floating : &driven) += end - since;
+    else
+        end = since;
+
+    e->mode = mode_opt >= 0 ? mode_opt : strcmp(sleep, "standby") == 0 ? MODE_STANDBY : MODE_SLEEP;
+    e->seconds = (double)(end - first) / hclk_hz;
+
+    // C x dV^2 / 2, dV in V/2 units
+    const double half = vdd / 2;
+    e->panel_uj = cell_pf * 1e-12 * cell_sq * half * half / 2 * 1e6;
+
+    // VDD^2 / 2R floating, VDD^2 / R driven
+    const double r = div_kohm * 1e3;
+    e->divider_uj = (vdd * vdd / (2 * r) * floating + vdd * vdd / r * driven) / hclk_hz * 1e6;
+
+    // Wake-ups are only counted over the whole trace, scale them to the active part
+    const sleep_mode_t* m       = &modes[e->mode];
+    const double        total_s = (double)end / hclk_hz;
+    const double        wakes   = e->mode == MODE_RUN ? 0 : wakeups * e->seconds / total_s;
+    e->mcu_uj = (m->ma * e->seconds + (modes[MODE_RUN].ma - m->ma) * wakes * m->wake_us * 1e-6) * 1e-3 * vdd * 1e6;
+
+    return 1;
+}
+
+static void print_row(const char* content, const char* mode, double frames, double seconds, double panel,
+                      double divider, double mcu)
+{
+    const double total = panel + divider + mcu;
+    printf("%-8s %-8s %7.0f %9.4f %9.4f %9.4f %9.4f %9.1f\n", content, mode, frames, panel / frames, divider / frames,
+           mcu / frames, total / frames, total / seconds / vdd);
+}
+
+static void usage(const char* name)
+{
+    fprintf(stderr,
+            "Usage: %s [-v vdd] [-c pF] [-r kOhm] [-m mode] [-i mA] [-a us] trace.csv ...\n"
+            "  -v vdd   Supply voltage, default 3.0V\n"
+            "  -c pF    Panel capacitance per segment, default 100pF\n"
+            "  -r kOhm  Each COM divider resistor, default 100kOhm\n"
+            "  -m mode  MCU between wake-ups, run, sleep or standby, default from the trace\n"
+            "  -i mA    MCU current in that mode, default run 2.5mA, sleep 1.2mA, standby 0.01mA\n"
+            "  -a us    MCU run time per wake-up, default sleep 2us, standby 35us\n",
+            name);
+    exit(2);
+}
+
+int main(int argc, char** argv)
+{
+    double ma_opt = -1, wake_opt = -1;
+    int    opt;
+
+    while ((opt = getopt(argc, argv, "v:c:r:m:i:a:")) != -1)
+    {
+        switch (opt)
+        {
+            case 'v': vdd = atof(optarg); break;
+            case 'c': cell_pf = atof(optarg); break;
+            case 'r': div_kohm = atof(optarg); break;
+            case 'm':
+                for (mode_opt = MODE_STANDBY; mode_opt >= 0 && strcmp(optarg, modes[mode_opt].name); mode_opt--) {}
+                if (mode_opt < 0)
+                    usage(argv[0]);
+                break;
+            case 'i': ma_opt = atof(optarg); break;
+            case 'a': wake_opt = atof(optarg); break;
+            default: usage(argv[0]);
+        }
+    }
+    if (optind >= argc)
+        usage(argv[0]);
+
+    // -i and -a apply to the mode of -m, or to both sleep modes
+    for (int i = MODE_RUN; i <= MODE_STANDBY; i++)
+        if (mode_opt < 0 ? i != MODE_RUN : i == mode_opt)
+        {
+            if (ma_opt >= 0)
+                modes[i].ma = ma_opt;
+            if (wake_opt >= 0)
+                modes[i].wake_us = wake_opt;
+        }
+
+    printf("VDD %.2fV, panel %.0fpF per segment, dividers 2 x %.0fkOhm per COM\n\n", vdd, cell_pf, div_kohm);
+    printf("                          |             uJ per frame               |\n");
+    printf("Content  MCU       Frames     Panel   Divider       MCU     Total        uA\n");
+
+    double   frames = 0, seconds = 0, panel = 0, divider = 0, mcu = 0;
+    uint32_t count = 0;
+    for (int i = optind; i < argc; i++)
+    {
+        estimate_t e;
+        if (!estimate(argv[i], &e))
+        {
+            printf("%-8s no frame\n", argv[i]);
+            continue;
+        }
+        print_row(e.content, modes[e.mode].name, e.frames, e.seconds, e.panel_uj, e.divider_uj, e.mcu_uj);
+
+        // Mean per frame over the corpus, each trace weighted by its frames
+        frames += e.frames;
+        seconds += e.seconds;
+        panel += e.panel_uj;
+        divider += e.divider_uj;
+        mcu += e.mcu_uj;
+        count++;
+    }
+
+    if (count > 1)
+    {
+        printf("\n");
+        print_row("Mean", "", frames, seconds, panel, divider, mcu);
+    }
+    return count ? 0 : 1;
+}
@@ -0,0 +1,738 @@
+/*
+ * CH32V003 Segment LCD - Host Simulator
+ *
+ * Compiles lcd.c against a register file in host RAM and runs it in simulated time.
+ *
+ * - main() of lcd.c runs unmodified until it sleeps in WFI or WFE, then the simulator advances time to the
+ *   next TIM2, DMA1, SysTick or AWU event and calls the interrupt handler, or does the DMA transfer.
+ * - After every event the GPIO pins are sampled, each pin change is recorded with its HCLK cycle.
+ * - The COM and SEG voltages are integrated per segment over each frame, using the 1/2 bias table in README,
+ *   a segment is lit if its RMS voltage is closer to the lit level than to the unlit level.
+ * - The decoded digits are printed as ASCII art whenever they change.
+ *
+ * -b emulates critical sections of the application, interrupts are masked for a while at a fixed period and
+ * the handlers run late, DMA transfers are not delayed.
+ *
+ * -C changes the contrast from main() at a fixed period, unrelated to the frame, so changes land between the
+ * 2 half-phases of a COM.
+ *
+ * -n and -s replace the demo content after every wake-up, for the energy corpus of make energy. The trace
+ * records the content, the sleep mode of the scan engine, the wake-ups and the end of the simulation in
+ * comment lines for lcd_energy.
+ *
+ * BSHR writes are applied to OUTDR at each sample point, which holds as long as the code writes each
+ * BSHR at most once per event, as all scan engines do.
+ */
+
+#include <setjmp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define main lcd_main
+#include "../lcd.c"
+#undef main
+
+// Register File
+GPIO_TypeDef        sim_gpioc;
+GPIO_TypeDef        sim_gpiod;
+TIM_TypeDef         sim_tim2;
+DMA_TypeDef         sim_dma1;
+DMA_Channel_TypeDef sim_dma1_channels[7];
+PWR_TypeDef         sim_pwr;
+RCC_TypeDef         sim_rcc;
+EXTI_TypeDef        sim_exti;
+SysTick_Type        sim_systick;
+PFIC_Type           sim_pfic;
+
+void SystemInit(void) {}
+
+// Simulated Time
+#define HCLK_HZ   FUNCONF_SYSTEM_CORE_CLOCK
+#define LSI_HZ    128000
+#define CYCLES_MS (HCLK_HZ / 1000)
+
+static uint64_t now     = 0;  // HCLK cycles
+static uint64_t end     = 0;
+static jmp_buf  sim_end;
+
+// Pins - COM1-4, SEG1-6
+// Levels in units of V/2: 0 - LOW, 1 - FLOAT (COM divider), 2 - HIGH
+#define PIN_COUNT 10
+
+static const uint8_t sim_pins[PIN_COUNT] = {PIN_COM1, PIN_COM2, PIN_COM3, PIN_COM4, PIN_SEG1,
+                                            PIN_SEG2, PIN_SEG3, PIN_SEG4, PIN_SEG5, PIN_SEG6};
+static const char*   pin_names[PIN_COUNT] = {"COM1", "COM2", "COM3", "COM4", "SEG1",
+                                             "SEG2", "SEG3", "SEG4", "SEG5", "SEG6"};
+
+static uint8_t  levels[PIN_COUNT];
+static uint64_t levels_since = 0;
+static FILE*    trace        = NULL;
+
+// Decoder - mean square of SEG - COM per cell over one frame window
+static uint64_t window        = 16 * CYCLES_MS;
+static uint64_t window_start  = 0;
+static int      window_active = 0;
+static uint64_t cell_sq[4][6];
+static char     shown[4]  = "";
+static int      show_art  = 1;
+static uint32_t frames    = 0;
+static uint32_t changes   = 0;
+
+static void decode_window(void);
+
+static void integrate(uint64_t until)
+{
+    while (window_active && until >= window_start + window)
+    {
+        const uint64_t boundary = window_start + window;
+        for (int c = 0; c < 4; c++)
+            for (int s = 0; s < 6; s++)
+            {
+                const int v = levels[4 + s] - levels[c];
+                cell_sq[c][s] += (uint64_t)(v * v) * (boundary - levels_since);
+            }
+        levels_since = boundary;
+        decode_window();
+        window_start = boundary;
+    }
+
+    for (int c = 0; c < 4; c++)
+        for (int s = 0; s < 6; s++)
+        {
+            const int v = levels[4 + s] - levels[c];
+            cell_sq[c][s] += (uint64_t)(v * v) * (until - levels_since);
+        }
+    levels_since = until;
+}
+
+static uint8_t pin_level(const GPIO_TypeDef* gpio, uint8_t pin)
+{
+    const uint8_t n   = pin & 0x0F;
+    const uint8_t cfg = (gpio->CFGLR >> (n * 4)) & 0x0F;
+
+    if ((cfg & 0x03) == 0)
+        return 1;  // Input - floating on the divider
+    return (gpio->OUTDR >> n) & 1 ? 2 : 0;
+}
+
+static void apply_bshr(GPIO_TypeDef* gpio)
+{
+    const uint32_t bshr = gpio->BSHR;
+    gpio->OUTDR         = (gpio->OUTDR & ~(bshr >> 16)) | (bshr & 0xFFFF);  // Set wins over reset
+    gpio->BSHR          = 0;
+}
+
+static void sample(void)
+{
+    apply_bshr(&sim_gpioc);
+    apply_bshr(&sim_gpiod);
+
+    uint8_t next[PIN_COUNT];
+    for (int i = 0; i < PIN_COUNT; i++)
+        next[i] = pin_level(GpioOf(sim_pins[i]), sim_pins[i]);
+
+    if (memcmp(next, levels, PIN_COUNT) == 0)
+        return;
+
+    integrate(now);
+    memcpy(levels, next, PIN_COUNT);
+
+    // Frame windows start at the first driven COM
+    if (!window_active && (levels[0] != 1 || levels[1] != 1 || levels[2] != 1 || levels[3] != 1))
+    {
+        window_active = 1;
+        window_start  = now;
+        memset(cell_sq, 0, sizeof(cell_sq));
+    }
+
+    if (trace)
+    {
+        fprintf(trace, "%llu", (unsigned long long)now);
+        for (int i = 0; i < PIN_COUNT; i++)
+            fprintf(trace, ",%u", levels[i]);
+        fputc('\n', trace);
+    }
+}
+
+// Decoder
+#define GLYPH_CHAR(a, name, c, segs) c,
+#define GLYPH_SEGS(a, name, c, segs) segs,
+static const char    glyph_chars[GLYPH_COUNT]        = {LCD_GLYPHS(GLYPH_CHAR, )};
+static const uint8_t character_segments[GLYPH_COUNT] = {LCD_GLYPHS(GLYPH_SEGS, )};
+
+static char glyph_char(uint8_t segs)
+{
+    for (int i = 0; i < GLYPH_COUNT; i++)
+        if (character_segments[i] == segs)
+            return glyph_chars[i];
+    return '?';
+}
+
+static void print_art(const uint8_t segs[3])
+{
+    // 0bDECGBFA
+    for (int row = 0; row < 3; row++)
+    {
+        printf("    ");
+        for (int d = 0; d < 3; d++)
+        {
+            const uint8_t s = segs[d];
+            if (row == 0)
+                printf(" %c  ", s & 0x01 ? '_' : ' ');
+            else if (row == 1)
+                printf("%c%c%c ", s & 0x02 ? '|' : ' ', s & 0x08 ? '_' : ' ', s & 0x04 ? '|' : ' ');
+            else
+                printf("%c%c%c ", s & 0x20 ? '|' : ' ', s & 0x40 ? '_' : ' ', s & 0x10 ? '|' : ' ');
+        }
+        putchar('\n');
+    }
+}
+
+static void decode_window(void)
+{
+    // Mean square in (V/2)^2, 1/4 duty 1/2 bias: lit = (4 x 4 + 12 x 1) / 16 = 1.75, unlit = 12 / 16 = 0.75
+    uint8_t masks[4] = {0, 0, 0, 0};
+    for (int c = 0; c < 4; c++)
+        for (int s = 0; s < 6; s++)
+            if (cell_sq[c][s] * 4 >= window * 5)  // >= 1.25
+                masks[c] |= 1 << s;
+    memset(cell_sq, 0, sizeof(cell_sq));
+    frames++;
+
+    // Invert calculate_seg_masks(), D1 in bits 5-4, D2 in bits 3-2, D3 in bits 1-0
+    uint8_t segs[3];
+    char    text[4];
+    for (int d = 0; d < 3; d++)
+    {
+        const int hi = 5 - d * 2, lo = 4 - d * 2;
+        segs[d]      = ((masks[0] >> hi) & 1) << 6 |  // D
+                  ((masks[1] >> hi) & 1) << 5 |       // E
+                  ((masks[1] >> lo) & 1) << 4 |       // C
+                  ((masks[2] >> hi) & 1) << 3 |       // G
+                  ((masks[2] >> lo) & 1) << 2 |       // B
+                  ((masks[3] >> hi) & 1) << 1 |       // F
+                  ((masks[3] >> lo) & 1) << 0;        // A
+        text[d] = glyph_char(segs[d]);
+    }
+    text[3] = '\0';
+
+    if (strcmp(text, shown) == 0)
+        return;
+
+    strcpy(shown, text);
+    changes++;
+    printf("[%9.1f ms] \"%s\"\n", (double)window_start / CYCLES_MS, text);
+    if (show_art)
+        print_art(segs);
+}
+
+// Interrupts - handlers not built for the selected scan engine are NULL
+void TIM2_IRQHandler(void) __attribute__((weak));
+void DMA1_Channel1_IRQHandler(void) __attribute__((weak));
+
+static void (*const tim2_handler)(void) = TIM2_IRQHandler;
+
+static uint64_t nvic_enabled = 0;
+
+// Critical sections - interrupts masked for cs_length cycles at the start of every cs_period cycles.
+// A handler requested inside one runs at its end, a second request of a pending handler is lost.
+#define DEFERRED_MAX 4
+
+static uint64_t cs_period = 0;
+static uint64_t cs_length = 0;
+static void (*deferred[DEFERRED_MAX])(void);
+static int      deferred_count = 0;
+static uint64_t deferred_at    = 0;
+
+static int is_deferred(void (*handler)(void))
+{
+    for (int i = 0; i < deferred_count; i++)
+        if (deferred[i] == handler)
+            return 1;
+    return 0;
+}
+
+static uint32_t wakeups = 0;  // Interrupt entries and AWU events
+
+static void run_handler(void (*handler)(void))
+{
+    const uint64_t offset = cs_period ? now % cs_period : cs_length;
+    if (offset < cs_length)
+    {
+        if (!is_deferred(handler) && deferred_count < DEFERRED_MAX)
+            deferred[deferred_count++] = handler;
+        deferred_at = now - offset + cs_length;
+        return;
+    }
+
+    wakeups++;
+    handler();
+    sample();
+}
+
+static void run_deferred(void)
+{
+    const int count = deferred_count;
+    deferred_count  = 0;
+    for (int i = 0; i < count; i++)
+    {
+        deferred[i]();
+        sample();
+    }
+}
+
+void sim_nvic_enable(IRQn_Type irq)
+{
+    nvic_enabled |= 1ull << irq;
+}
+
+void sim_nvic_disable(IRQn_Type irq)
+{
+    nvic_enabled &= ~(1ull << irq);
+}
+
+static int irq_enabled(IRQn_Type irq)
+{
+    return (nvic_enabled >> irq) & 1;
+}
+
+// DMA1 - only memory to peripheral 32-bit transfers are simulated
+typedef struct
+{
+    uint32_t maddr;
+    uint32_t count;
+    uint32_t pos;
+    int      enabled;
+} dma_state_t;
+
+static dma_state_t dma_state[7];
+
+static void (*const dma_handlers[7])(void) = {
+    DMA1_Channel1_IRQHandler, 0, 0, 0, 0, 0, 0,
+};
+
+static void dma_request(int channel)
+{
+    DMA_Channel_TypeDef* ch    = &sim_dma1_channels[channel];
+    dma_state_t*         state = &dma_state[channel];
+
+    if (!(ch->CFGR & DMA_CFGR1_EN))
+    {
+        state->enabled = 0;
+        return;
+    }
+
+    // Latch the transfer when the channel is enabled or re-pointed
+    if (!state->enabled || state->maddr != ch->MADDR)
+    {
+        state->enabled = 1;
+        state->maddr   = ch->MADDR;
+        state->count   = ch->CNTR;
+        state->pos     = 0;
+    }
+    if (state->count == 0)
+        return;
+
+    const uint32_t word = *(volatile uint32_t*)(uintptr_t)(state->maddr + state->pos * 4);
+    *(volatile uint32_t*)(uintptr_t)ch->PADDR = word;
+    sample();
+
+    if (++state->pos < state->count)
+    {
+        ch->CNTR = state->count - state->pos;
+        return;
+    }
+
+    // Transfer complete, CNTR is reloaded in circular mode before the interrupt
+    state->pos = 0;
+    ch->CNTR   = state->count;
+    if (!(ch->CFGR & DMA_CFGR1_CIRC))
+        ch->CFGR &= ~DMA_CFGR1_EN;
+
+    sim_dma1.INTFR |= DMA_TCIF1 << (channel * 4);
+    if ((ch->CFGR & DMA_CFGR1_TCIE) && irq_enabled(DMA1_Channel1_IRQn + channel) && dma_handlers[channel])
+        run_handler(dma_handlers[channel]);
+}
+
+// TIM2 - update and compare events, as interrupts or DMA requests
+// Event 0 - UP, 1-4 - CC1-CC4
+static const int tim2_dma_channels[5] = {1, 4, 6, 0, 6};  // UP - Channel2, CC1 - Channel5, CC2/CC4 - Channel7, CC3 - Channel1
+
+static int      tim2_running = 0;
+static uint64_t tim2_start   = 0;  // Cycle of the last update
+static uint8_t  tim2_fired   = 0;  // Events done in this period
+static uint32_t tim2_arr     = 0;  // Active ATRLR and CH1CVR - CH4CVR, loaded at each update, used with ARPE
+static uint32_t tim2_ccrs[4];      // and OCxPE set, so preloaded writes take effect at the next update
+
+static uint64_t tim2_tick(void)
+{
+    return (uint64_t)sim_tim2.PSC + 1;
+}
+
+static void tim2_load(void)
+{
+    const volatile uint32_t* ccr = &sim_tim2.CH1CVR;
+
+    tim2_arr = sim_tim2.ATRLR;
+    for (int e = 1; e <= 4; e++)
+        tim2_ccrs[e - 1] = ccr[e - 1];
+}
+
+static uint32_t tim2_atrlr(void)
+{
+    return sim_tim2.CTLR1 & TIM_ARPE ? tim2_arr : sim_tim2.ATRLR;
+}
+
+static uint32_t tim2_ccr(int event)
+{
+    static const uint16_t    preload[4] = {TIM_OC1PE, TIM_OC2PE, TIM_OC3PE, TIM_OC4PE};
+    const volatile uint32_t* ccr        = &sim_tim2.CH1CVR;
+    const uint32_t           chctlr     = event <= 2 ? sim_tim2.CHCTLR1 : sim_tim2.CHCTLR2;
+
+    return chctlr & preload[event - 1] ? tim2_ccrs[event - 1] : ccr[event - 1];
+}
+
+static int tim2_next(uint64_t* when, int* event)
+{
+    if (!(sim_tim2.CTLR1 & TIM_CEN))
+    {
+        tim2_running = 0;
+        return 0;
+    }
+
+    if (!tim2_running)
+    {
+        tim2_running = 1;
+        tim2_load();  // Loaded by the TIM_UG of lcd_start()
+        tim2_fired   = 0x1E;  // The first period starts at CNT, compares before it are skipped
+        tim2_start   = now - (uint64_t)sim_tim2.CNT * tim2_tick();
+        for (int e = 1; e <= 4; e++)
+            if (tim2_ccr(e) > sim_tim2.CNT)
+                tim2_fired &= ~(1 << e);
+    }
+
+    *when  = tim2_start + ((uint64_t)tim2_atrlr() + 1) * tim2_tick();
+    *event = 0;
+    for (int e = 1; e <= 4; e++)
+    {
+        const uint16_t enable = (TIM_CC1IE << (e - 1)) | (TIM_CC1DE << (e - 1));
+        if (tim2_fired & (1 << e) || !(sim_tim2.DMAINTENR & enable) || tim2_ccr(e) > tim2_atrlr())
+            continue;
+
+        const uint64_t at = tim2_start + tim2_ccr(e) * tim2_tick();
+        if (at < *when)
+        {
+            *when  = at;
+            *event = e;
+        }
+    }
+    return 1;
+}
+
+static void tim2_dispatch(int event)
+{
+    if (event == 0)
+    {
+        tim2_start   = now;
+        tim2_fired   = 0;
+        sim_tim2.CNT = 0;
+        tim2_load();
+    }
+    tim2_fired |= 1 << event;
+
+    const uint16_t flag = event == 0 ? TIM_UIF : TIM_CC1IF << (event - 1);
+    const uint16_t ie   = event == 0 ? TIM_UIE : TIM_CC1IE << (event - 1);
+    const uint16_t de   = event == 0 ? TIM_UDE : TIM_CC1DE << (event - 1);
+
+    // INTFR is plain memory, the rc_w0 clear of the handler can't be emulated, so only this event is flagged.
+    sim_tim2.INTFR = flag;
+    if (sim_tim2.DMAINTENR & de)
+        dma_request(tim2_dma_channels[event]);
+    if ((sim_tim2.DMAINTENR & ie) && irq_enabled(TIM2_IRQn) && tim2_handler)
+        run_handler(tim2_handler);
+}
+
+// SysTick - compare interrupt, counting HCLK
+static int systick_next(uint64_t* when)
+{
+    const uint32_t ctlr = SYSTICK_CTLR_STE | SYSTICK_CTLR_STIE;
+    if ((sim_systick.CTLR & ctlr) != ctlr || !irq_enabled(SysTicK_IRQn) || is_deferred(SysTick_Handler))
+        return 0;
+
+    *when = sim_systick.CMP;  // CNT counts from 0 at cycle 0, see systick_init()
+    if (*when < now)
+        *when = now;
+    return 1;
+}
+
+static void advance(uint64_t when)
+{
+    if (when >= end)
+    {
+        now = end;
+        integrate(now);
+        longjmp(sim_end, 1);
+    }
+    now             = when;
+    sim_systick.CNT = (uint32_t)now;
+    if (tim2_running)
+        sim_tim2.CNT = (uint32_t)((now - tim2_start) / tim2_tick());
+}
+
+// Content - -n glyph on all 3 digits, or -s text, instead of the demo
+static int         content_glyph = -1;
+static const char* content_text  = NULL;
+
+static void sim_content(void)
+{
+    if (content_glyph >= 0)
+        show_glyphs(content_glyph, content_glyph, content_glyph);
+    else if (content_text)
+        show_string(content_text);
+}
+
+// Contrast changes - -C ms,level alternates lcd_set_contrast() between level and -c from main()
+static uint64_t contrast_period = 0;
+static uint64_t contrast_next   = 0;
+static uint8_t  contrast_levels[2];
+static uint8_t  contrast_index = 0;
+
+static void sim_contrast(void)
+{
+    if (!contrast_period || now < contrast_next)
+        return;
+
+    contrast_next += contrast_period;
+    contrast_index ^= 1;
+    lcd_set_contrast(contrast_levels[contrast_index]);
+}
+
+void sim_wfi(void)
+{
+    sim_content();
+    sim_contrast();
+    sample();
+
+    uint64_t tim2_when = 0, systick_when = 0;
+    int      tim2_event = 0;
+    const int has_tim2    = tim2_next(&tim2_when, &tim2_event);
+    const int has_systick = systick_next(&systick_when);
+
+    if (!has_tim2 && !has_systick && !deferred_count)
+    {
+        fprintf(stderr, "lcd_sim: WFI with no interrupt source enabled\n");
+        exit(1);
+    }
+
+    if (deferred_count && (!has_tim2 || deferred_at <= tim2_when) && (!has_systick || deferred_at <= systick_when))
+    {
+        advance(deferred_at);
+        run_deferred();
+    }
+    else if (has_tim2 && (!has_systick || tim2_when <= systick_when))
+    {
+        advance(tim2_when);
+        tim2_dispatch(tim2_event);
+    }
+    else
+    {
+        advance(systick_when);
+        sim_systick.SR = 1;
+        run_handler(SysTick_Handler);
+    }
+}
+
+// AWU - standby until the AWU event, HCLK and every other clock source stop
+void sim_wfe(void)
+{
+    static const uint16_t prescalers[16] = {1, 1, 2, 4, 8, 16, 32, 64, 128, 256, 512, 1024, 2048, 4096, 10240, 61440};
+
+    sim_content();
+    sim_contrast();
+    sample();
+
+    if (!(sim_pwr.AWUCSR & PWR_AWUCSR_AWUEN) || !(sim_exti.EVENR & EXTI_Line9))
+    {
+        fprintf(stderr, "lcd_sim: WFE with no AWU event enabled\n");
+        exit(1);
+    }
+
+    const uint64_t lsi_ticks = (uint64_t)(sim_pwr.AWUWR & 0x3F) * prescalers[sim_pwr.AWUPSC & 0x0F];
+    advance(now + lsi_ticks * HCLK_HZ / LSI_HZ);
+    wakeups++;
+}
+
+// Drive Schemes - SEG edges of each frame table built for every D1 D2 D3 glyph combination
+static uint32_t table_edges(void)
+{
+    const uint32_t* const words = frame.gpioc_bshr[front ^ 1];
+    uint32_t              edges = 0;
+
+    // Level of SEG1-6 after each word is its set bits, back to the first word at the end of the table
+    for (int k = 0; k < LCD_SEG_WORDS; k++)
+        edges += __builtin_popcount((words[k] ^ words[(k + 1) % LCD_SEG_WORDS]) & 0x3F);
+    return edges;
+}
+
+static void glyph_edges(void)
+{
+    static const char* const names[3] = {"LCD_DRIVE_LINE", "LCD_DRIVE_FRAME", "LCD_DRIVE_ORDER"};
+    const uint32_t           count    = GLYPH_COUNT * GLYPH_COUNT * GLYPH_COUNT;
+    double                   line     = 0;
+
+    printf("SEG edges per frame table, %u glyph combinations\n\n", count);
+    printf("Drive              Mean  Min  Max  Saved\n");
+    for (uint8_t mode = LCD_DRIVE_LINE; mode <= LCD_DRIVE_ORDER; mode++)
+    {
+        uint64_t total = 0;
+        uint32_t min = UINT32_MAX, max = 0;
+
+        drive_mode = mode;
+        for (uint8_t d1 = 0; d1 < GLYPH_COUNT; d1++)
+            for (uint8_t d2 = 0; d2 < GLYPH_COUNT; d2++)
+                for (uint8_t d3 = 0; d3 < GLYPH_COUNT; d3++)
+                {
+                    show_glyphs(d1, d2, d3);
+                    const uint32_t edges = table_edges();
+                    total += edges;
+                    min = edges < min ? edges : min;
+                    max = edges > max ? edges : max;
+                }
+
+        const double mean = (double)total / count;
+        if (mode == LCD_DRIVE_LINE)
+            line = mean;
+        printf("%-16s %6.2f %4u %4u %5.1f%%\n", names[mode], mean, min, max, (1 - mean / line) * 100);
+    }
+}
+
+static void usage(const char* name)
+{
+    fprintf(stderr,
+            "Usage: %s [-t ms] [-w ms] [-p us] [-f us] [-c level] [-C ms,level] [-b ms,us] [-i | -m]\n"
+            "          [-n glyph | -s text] [-o trace.csv] [-q] [-g] [-G]\n"
+            "  -t ms         Simulated time, default 8000ms\n"
+            "  -w ms         Frame window for decoding segments, default 8 half-phases\n"
+            "  -p us         Half-phase period, lcd_set_timing(), default 2000us\n"
+            "  -f us         All-float slot at the end of each half-phase, default 0us\n"
+            "  -c level      lcd_set_contrast() 1 - 16 after -p and -f, default none\n"
+            "  -C ms,level   Alternate lcd_set_contrast() between level and -c every ms, default none\n"
+            "  -b ms,us      Critical sections, interrupts masked for us every ms, default none\n"
+            "  -i            Frame inversion drive, LCD_DRIVE_FRAME, default LCD_DRIVE_LINE\n"
+            "  -m            Frame inversion in the COM order with the fewest SEG edges, LCD_DRIVE_ORDER\n"
+            "  -n glyph      Show glyph 0 - %d on all 3 digits instead of the demo\n"
+            "  -s text       Show text with show_string() instead of the demo\n"
+            "  -o trace.csv  Record every pin change, levels in V/2 units: 0 - LOW, 1 - FLOAT, 2 - HIGH\n"
+            "  -q            Print the decoded text only, no ASCII art\n"
+            "  -g            Print the SEG edges per frame table of each drive scheme over all glyphs, then exit\n"
+            "  -G            Print the glyph count, for the glyph numbers of -n, then exit\n",
+            name, GLYPH_COUNT - 1);
+    exit(2);
+}
+
+int main(int argc, char** argv)
+{
+    double   end_ms       = 8000;
+    double   window_ms    = 0;
+    uint16_t phase_opt    = LCD_PHASE_US;
+    uint16_t float_opt    = 0;
+    uint8_t  contrast_opt = 0;
+    int      opt;
+
+    while ((opt = getopt(argc, argv, "t:w:p:f:c:C:b:imn:s:o:qgG")) != -1)
+    {
+        switch (opt)
+        {
+            case 't': end_ms = atof(optarg); break;
+            case 'w': window_ms = atof(optarg); break;
+            case 'p': phase_opt = atoi(optarg); break;
+            case 'f': float_opt = atoi(optarg); break;
+            case 'c': contrast_opt = atoi(optarg); break;
+            case 'C':
+            {
+                double   period_ms;
+                unsigned level;
+                if (sscanf(optarg, "%lf,%u", &period_ms, &level) != 2 || period_ms <= 0)
+                    usage(argv[0]);
+                contrast_period    = (uint64_t)(period_ms * CYCLES_MS);
+                contrast_next      = contrast_period;
+                contrast_levels[1] = level;
+                break;
+            }
+            case 'b':
+            {
+                double period_ms, length_us;
+                if (sscanf(optarg, "%lf,%lf", &period_ms, &length_us) != 2 || period_ms <= 0)
+                    usage(argv[0]);
+                cs_period = (uint64_t)(period_ms * CYCLES_MS);
+                cs_length = (uint64_t)(length_us * CYCLES_MS / 1000);
+                break;
+            }
+            case 'o':
+                trace = fopen(optarg, "w");
+                if (!trace)
+                {
+                    perror(optarg);
+                    return 1;
+                }
+                break;
+            case 'i': drive_mode = LCD_DRIVE_FRAME; break;
+            case 'm': drive_mode = LCD_DRIVE_ORDER; break;
+            case 'n':
+                content_glyph = atoi(optarg);
+                if (content_glyph < 0 || content_glyph >= GLYPH_COUNT)
+                    usage(argv[0]);
+                break;
+            case 's': content_text = optarg; break;
+            case 'q': show_art = 0; break;
+            case 'g': glyph_edges(); return 0;
+            case 'G': printf("%d\n", GLYPH_COUNT); return 0;
+            default: usage(argv[0]);
+        }
+    }
+
+    end    = (uint64_t)(end_ms * CYCLES_MS);
+    window = window_ms ? (uint64_t)(window_ms * CYCLES_MS) : (uint64_t)phase_opt * 8 * CYCLES_MS / 1000;
+
+    if (trace)
+    {
+        fprintf(trace, "# hclk_hz=%u\n", HCLK_HZ);
+        fprintf(trace, "# sleep=%s\n", LCD_SCAN_ENGINE == LCD_SCAN_AWU ? "standby" : "sleep");
+        if (content_glyph >= 0)
+            fprintf(trace, "# content=%c%c%c\n", glyph_chars[content_glyph], glyph_chars[content_glyph],
+                    glyph_chars[content_glyph]);
+        else
+            fprintf(trace, "# content=%s\n", content_text ? content_text : "demo");
+        fprintf(trace, "cycle");
+        for (int i = 0; i < PIN_COUNT; i++)
+            fprintf(trace, ",%s", pin_names[i]);
+        fputc('\n', trace);
+    }
+
+    // Reset values
+    sim_rcc.RSTSCKR = RCC_LSIRDY;
+    sim_gpioc.CFGLR = 0x44444444;
+    sim_gpiod.CFGLR = 0x44444444;
+    memset(levels, 1, sizeof(levels));
+
+    // Stored before main(), lcd_start() loads it
+    lcd_set_timing(phase_opt, float_opt);
+    if (contrast_opt)
+        lcd_set_contrast(contrast_opt);
+    contrast_levels[0] = contrast_opt ? contrast_opt : LCD_CONTRAST_MAX;
+
+    if (setjmp(sim_end) == 0)
+        lcd_main();
+
+    printf("%.1f ms simulated, %u frames, %u display changes\n", (double)now / CYCLES_MS, frames, changes);
+
+    if (trace)
+    {
+        fprintf(trace, "# wakeups=%u\n", wakeups);
+        fprintf(trace, "# end=%llu\n", (unsigned long long)now);
+        fclose(trace);
+    }
+    return 0;
+}
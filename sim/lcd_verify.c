@@ -0,0 +1,240 @@
+/*
+ * CH32V003 Segment LCD - Waveform Verifier
+ *
+ * Checks a pin-transition trace of any scan engine, as recorded by lcd_sim -o, for
+ * - DC balance - the mean of SEG - COM of each of the 24 segment cells over every frame window must be 0.
+ * - Contrast   - the RMS of SEG - COM of lit cells over the RMS of unlit cells must stay above a ratio.
+ *
+ * Trace format, levels in units of V/2: 0 - LOW, 1 - FLOAT (COM divider), 2 - HIGH
+ *   # hclk_hz=24000000
+ *   cycle,COM1,COM2,COM3,COM4,SEG1,SEG2,SEG3,SEG4,SEG5,SEG6
+ *   0,2,1,1,1,2,2,2,2,2,2
+ *
+ * Frame windows start at the first driven COM. Use -w to cover a whole AC cycle of the drive scheme,
+ * e.g. 2 frames for frame inversion.
+ *
+ * Also counts the pin transitions per second from the first driven COM on, the capacitive switching of the
+ * panel is proportional to them.
+ */
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define PIN_COUNT 10
+
+static uint64_t window    = 0;  // HCLK cycles
+static double   vdd       = 3.0;
+static double   max_dc    = 0.1;  // % of VDD
+static double   min_ratio = 1.5;
+
+// Per window
+static int64_t  cell_sum[4][6];  // SEG - COM x cycles, in V/2
+static uint64_t cell_sq[4][6];   // (SEG - COM)^2 x cycles, in (V/2)^2
+
+// Whole trace
+static double   worst_dc[4][6];  // % of VDD
+static double   min_on_rms  = INFINITY;
+static double   max_off_rms = 0;
+static double   min_window_ratio = INFINITY;
+static uint32_t windows    = 0;
+static uint32_t dc_failures = 0;
+static uint32_t ratio_failures = 0;
+static uint64_t transitions[PIN_COUNT];
+
+static void accumulate(const uint8_t levels[PIN_COUNT], uint64_t cycles)
+{
+    for (int c = 0; c < 4; c++)
+        for (int s = 0; s < 6; s++)
+        {
+            const int v = levels[4 + s] - levels[c];
+            cell_sum[c][s] += (int64_t)v * (int64_t)cycles;
+            cell_sq[c][s] += (uint64_t)(v * v) * cycles;
+        }
+}
+
+static void check_window(uint64_t start)
+{
+    double on_rms = INFINITY, off_rms = 0;
+
+    for (int c = 0; c < 4; c++)
+        for (int s = 0; s < 6; s++)
+        {
+            // V/2 units -> % of VDD, (V/2)^2 units -> V
+            const double dc  = fabs((double)cell_sum[c][s] / window) * 50.0;
+            const double ms  = (double)cell_sq[c][s] / window;
+            const double rms = sqrt(ms) * vdd / 2;
+
+            if (dc > worst_dc[c][s])
+                worst_dc[c][s] = dc;
+            if (dc > max_dc)
+            {
+                if (dc_failures++ < 10)
+                    printf("DC   FAIL  window @ %llu: COM%d SEG%d %.3f%% of VDD\n", (unsigned long long)start, c + 1,
+                           s + 1, dc);
+            }
+
+            // Lit above the midpoint of the 1/4 duty 1/2 bias levels, 1.75 and 0.75 (V/2)^2
+            if (ms >= 1.25)
+                on_rms = rms < on_rms ? rms : on_rms;
+            else
+                off_rms = rms > off_rms ? rms : off_rms;
+        }
+
+    memset(cell_sum, 0, sizeof(cell_sum));
+    memset(cell_sq, 0, sizeof(cell_sq));
+    windows++;
+
+    if (on_rms < min_on_rms)
+        min_on_rms = on_rms;
+    if (off_rms > max_off_rms)
+        max_off_rms = off_rms;
+
+    // Blank or all lit windows have no ratio
+    if (isinf(on_rms) || off_rms == 0)
+        return;
+
+    const double ratio = on_rms / off_rms;
+    if (ratio < min_window_ratio)
+        min_window_ratio = ratio;
+    if (ratio < min_ratio && ratio_failures++ < 10)
+        printf("RMS  FAIL  window @ %llu: on %.3fV / off %.3fV = %.3f\n", (unsigned long long)start, on_rms, off_rms,
+               ratio);
+}
+
+static void usage(const char* name)
+{
+    fprintf(stderr,
+            "Usage: %s [-w ms] [-v vdd] [-d %%] [-r ratio] trace.csv\n"
+            "  -w ms     Frame window, default 16ms\n"
+            "  -v vdd    Supply voltage, default 3.0V\n"
+            "  -d %%      Maximum DC offset per cell and window, default 0.1%% of VDD\n"
+            "  -r ratio  Minimum on/off RMS ratio, default 1.5\n",
+            name);
+    exit(2);
+}
+
+int main(int argc, char** argv)
+{
+    double window_ms = 16;
+    int    opt;
+
+    while ((opt = getopt(argc, argv, "w:v:d:r:")) != -1)
+    {
+        switch (opt)
+        {
+            case 'w': window_ms = atof(optarg); break;
+            case 'v': vdd = atof(optarg); break;
+            case 'd': max_dc = atof(optarg); break;
+            case 'r': min_ratio = atof(optarg); break;
+            default: usage(argv[0]);
+        }
+    }
+    if (optind != argc - 1)
+        usage(argv[0]);
+
+    FILE* f = fopen(argv[optind], "r");
+    if (!f)
+    {
+        perror(argv[optind]);
+        return 2;
+    }
+
+    char     line[256];
+    uint32_t hclk_hz = 24000000;
+    uint8_t  levels[PIN_COUNT];
+    uint64_t since  = 0;
+    uint64_t start  = 0;
+    uint64_t first  = 0;
+    uint64_t last   = 0;
+    int      active = 0;
+
+    while (fgets(line, sizeof(line), f))
+    {
+        if (line[0] == '#')
+        {
+            sscanf(line, "# hclk_hz=%u", &hclk_hz);
+            continue;
+        }
+        if (line[0] < '0' || line[0] > '9')
+            continue;  // Header
+
+        unsigned long long cycle;
+        unsigned           l[PIN_COUNT];
+        if (sscanf(line, "%llu,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u", &cycle, &l[0], &l[1], &l[2], &l[3], &l[4], &l[5], &l[6],
+                   &l[7], &l[8], &l[9]) != PIN_COUNT + 1)
+        {
+            fprintf(stderr, "Bad trace line: %s", line);
+            return 2;
+        }
+        window = (uint64_t)(window_ms * hclk_hz / 1000);
+
+        // Integrate the previous levels up to this change, closing windows on the way
+        while (active && cycle >= start + window)
+        {
+            accumulate(levels, start + window - since);
+            since = start + window;
+            check_window(start);
+            start += window;
+        }
+        if (active)
+        {
+            accumulate(levels, cycle - since);
+            for (int i = 0; i < PIN_COUNT; i++)
+                transitions[i] += levels[i] != l[i];
+        }
+
+        for (int i = 0; i < PIN_COUNT; i++)
+            levels[i] = l[i];
+        since = cycle;
+        last  = cycle;
+
+        if (!active && (levels[0] != 1 || levels[1] != 1 || levels[2] != 1 || levels[3] != 1))
+        {
+            active = 1;
+            start  = cycle;
+            first  = cycle;
+        }
+    }
+    fclose(f);
+
+    if (windows == 0)
+    {
+        printf("No complete frame window in the trace\n");
+        return 1;
+    }
+
+    printf("%u windows of %.3fms, VDD %.2fV\n\n", windows, window_ms, vdd);
+    printf("Worst DC offset, %% of VDD\n");
+    printf("        SEG1    SEG2    SEG3    SEG4    SEG5    SEG6\n");
+    for (int c = 0; c < 4; c++)
+    {
+        printf("COM%d", c + 1);
+        for (int s = 0; s < 6; s++)
+            printf("  %6.3f", worst_dc[c][s]);
+        putchar('\n');
+    }
+
+    printf("\nMinimum on RMS   %.3fV\n", min_on_rms);
+    printf("Maximum off RMS  %.3fV\n", max_off_rms);
+    printf("Minimum ratio    %.3f\n\n", min_window_ratio);
+
+    // Transitions per second, COMs and SEGs
+    const double seconds = (double)(last - first) / hclk_hz;
+    uint64_t     com = 0, seg = 0;
+    for (int i = 0; i < PIN_COUNT; i++)
+        *(i < 4 ? &com : &seg) += transitions[i];
+    printf("Transitions/s    COM %.1f  SEG %.1f  Total %.1f\n\n", com / seconds, seg / seconds, (com + seg) / seconds);
+
+    if (dc_failures || ratio_failures)
+    {
+        printf("FAIL - %u DC offset, %u RMS ratio violations\n", dc_failures, ratio_failures);
+        return 1;
+    }
+
+    printf("PASS\n");
+    return 0;
+}
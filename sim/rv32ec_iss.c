@@ -0,0 +1,673 @@
+/*
+ * CH32V003 Segment LCD - RV32EC Instruction Set Simulator
+ *
+ * Runs functions of an rv32ec ELF, as built by make bench, and counts instructions and cycles per call.
+ *
+ * - RV32E base integer and C compressed instructions, plus the CSR instructions and MRET of interrupt handlers.
+ * - Flash at 0x00000000 (aliased at 0x08000000), 2KB SRAM at 0x20000000, the stack starts at the top of SRAM.
+ * - Peripheral and core registers are plain memory, so register writes cost what they cost, without side effects.
+ * - Each call returns to a magic address through RA, or MEPC for interrupt handlers.
+ * - -t runs rv32ec_test.s, llvm-mc encoded, to check the decoder and the cycle model without a RISC-V toolchain.
+ *
+ * Cycle model, QingKe V2A, 2-stage pipeline, flash 0 wait states at HCLK <= 24MHz.
+ * Interrupt entry and exit latency of the PFIC is not counted, only the handler body.
+ *
+ * | Instruction                   | Cycles |
+ * | ----------------------------- | ------ |
+ * | ALU, LUI, AUIPC, CSR          | 1      |
+ * | Store                         | 1      |
+ * | Load                          | 2      |
+ * | Branch not taken              | 1      |
+ * | Branch taken, JAL, JALR, MRET | 3      |
+ *
+ * Calls are "name[:arg,...][*count]", args are numbers or @symbol for the address of a symbol, e.g.
+ *   show_string:@bench_text
+ *   TIM2_IRQHandler*8
+ * Calls run in order on the same memory, so a call can set up the state of the next ones.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "rv32ec_test.h"
+
+#define CYCLES_ALU    1
+#define CYCLES_STORE  1
+#define CYCLES_LOAD   2
+#define CYCLES_BRANCH 1
+#define CYCLES_JUMP   3
+
+#define CALL_LIMIT    1000000  // Instructions
+#define RETURN_MAGIC  0xFFFFFFF0u
+#define MAX_ARGS      6        // a0-a5
+
+// Memory Map
+typedef struct
+{
+    uint32_t base;
+    uint32_t size;
+    uint8_t* data;
+} region_t;
+
+static uint8_t flash[16 * 1024];
+static uint8_t sram[2 * 1024];
+static uint8_t peripherals[0x24000];  // TIM2 0x40000000 - RCC 0x40021000
+static uint8_t core[0x2000];          // PFIC 0xE000E000, SysTick 0xE000F000
+
+static const region_t regions[] = {
+    {0x00000000, sizeof(flash), flash},
+    {0x08000000, sizeof(flash), flash},
+    {0x20000000, sizeof(sram), sram},
+    {0x40000000, sizeof(peripherals), peripherals},
+    {0xE000E000, sizeof(core), core},
+};
+
+// CPU
+static uint32_t x[16];
+static uint32_t pc;
+static uint32_t csr[4096];
+static uint64_t instructions;
+static uint64_t cycles;
+
+static void __attribute__((noreturn)) fault(const char* what, uint32_t addr)
+{
+    fprintf(stderr, "%s 0x%08x at pc 0x%08x\n", what, addr, pc);
+    exit(1);
+}
+
+static uint8_t* mem(uint32_t addr, uint32_t size)
+{
+    for (size_t i = 0; i < sizeof(regions) / sizeof(regions[0]); i++)
+        if (addr >= regions[i].base && addr - regions[i].base + size <= regions[i].size)
+            return regions[i].data + (addr - regions[i].base);
+    fault("Bad access", addr);
+    return NULL;
+}
+
+static uint32_t load(uint32_t addr, uint32_t size)
+{
+    const uint8_t* p = mem(addr, size);
+    uint32_t       v = 0;
+    for (uint32_t i = 0; i < size; i++)
+        v |= (uint32_t)p[i] << (i * 8);
+    return v;
+}
+
+static void store(uint32_t addr, uint32_t size, uint32_t v)
+{
+    uint8_t* p = mem(addr, size);
+    for (uint32_t i = 0; i < size; i++)
+        p[i] = v >> (i * 8);
+}
+
+static inline int32_t sext(uint32_t v, int bits)
+{
+    return (int32_t)(v << (32 - bits)) >> (32 - bits);
+}
+
+static inline uint32_t bits(uint32_t v, int hi, int lo)
+{
+    return (v >> lo) & ((1u << (hi - lo + 1)) - 1);
+}
+
+static inline uint32_t reg(uint32_t r)
+{
+    if (r > 15)
+        fault("Register beyond x15 in", pc);
+    return x[r];
+}
+
+static inline void set_reg(uint32_t r, uint32_t v)
+{
+    if (r > 15)
+        fault("Register beyond x15 in", pc);
+    if (r)
+        x[r] = v;
+}
+
+// Compressed Instructions, expanded to their 32-bit form
+static uint32_t encode_i(uint32_t op, uint32_t rd, uint32_t f3, uint32_t rs1, int32_t imm)
+{
+    return ((uint32_t)imm << 20) | (rs1 << 15) | (f3 << 12) | (rd << 7) | op;
+}
+
+static uint32_t encode_s(uint32_t op, uint32_t f3, uint32_t rs1, uint32_t rs2, int32_t imm)
+{
+    return (bits(imm, 11, 5) << 25) | (rs2 << 20) | (rs1 << 15) | (f3 << 12) | (bits(imm, 4, 0) << 7) | op;
+}
+
+static uint32_t encode_r(uint32_t op, uint32_t rd, uint32_t f3, uint32_t rs1, uint32_t rs2, uint32_t f7)
+{
+    return (f7 << 25) | (rs2 << 20) | (rs1 << 15) | (f3 << 12) | (rd << 7) | op;
+}
+
+static uint32_t encode_b(uint32_t f3, uint32_t rs1, uint32_t rs2, int32_t imm)
+{
+    return (bits(imm, 12, 12) << 31) | (bits(imm, 10, 5) << 25) | (rs2 << 20) | (rs1 << 15) | (f3 << 12) |
+           (bits(imm, 4, 1) << 8) | (bits(imm, 11, 11) << 7) | 0x63;
+}
+
+static uint32_t encode_j(uint32_t rd, int32_t imm)
+{
+    return (bits(imm, 20, 20) << 31) | (bits(imm, 10, 1) << 21) | (bits(imm, 11, 11) << 20) |
+           (bits(imm, 19, 12) << 12) | (rd << 7) | 0x6F;
+}
+
+static uint32_t expand(uint16_t c)
+{
+    const uint32_t rd    = bits(c, 11, 7);
+    const uint32_t rs2   = bits(c, 6, 2);
+    const uint32_t rd_   = 8 + bits(c, 4, 2);  // rd', rs2'
+    const uint32_t rs1_  = 8 + bits(c, 9, 7);  // rs1', rd'
+    const int32_t  imm6  = sext((bits(c, 12, 12) << 5) | bits(c, 6, 2), 6);
+    const int32_t  j_imm = sext((bits(c, 12, 12) << 11) | (bits(c, 11, 11) << 4) | (bits(c, 10, 9) << 8) |
+                                    (bits(c, 8, 8) << 10) | (bits(c, 7, 7) << 6) | (bits(c, 6, 6) << 7) |
+                                    (bits(c, 5, 3) << 1) | (bits(c, 2, 2) << 5),
+                                12);
+    const int32_t  b_imm = sext((bits(c, 12, 12) << 8) | (bits(c, 11, 10) << 3) | (bits(c, 6, 5) << 6) |
+                                    (bits(c, 4, 3) << 1) | (bits(c, 2, 2) << 5),
+                                9);
+    const uint32_t w_imm = (bits(c, 12, 10) << 3) | (bits(c, 6, 6) << 2) | (bits(c, 5, 5) << 6);
+
+    switch ((bits(c, 1, 0) << 3) | bits(c, 15, 13))
+    {
+        case 000:  // C.ADDI4SPN
+        {
+            const uint32_t imm = (bits(c, 12, 11) << 4) | (bits(c, 10, 7) << 6) | (bits(c, 6, 6) << 2) |
+                                 (bits(c, 5, 5) << 3);
+            if (imm == 0)
+                break;
+            return encode_i(0x13, rd_, 0, 2, imm);
+        }
+        case 002: return encode_i(0x03, rd_, 2, rs1_, w_imm);          // C.LW
+        case 006: return encode_s(0x23, 2, rs1_, rd_, w_imm);          // C.SW
+        case 010: return encode_i(0x13, rd, 0, rd, imm6);              // C.ADDI, C.NOP
+        case 011: return encode_j(1, j_imm);                           // C.JAL
+        case 012: return encode_i(0x13, rd, 0, 0, imm6);               // C.LI
+        case 013:
+            if (rd == 2)  // C.ADDI16SP
+            {
+                const int32_t imm = sext((bits(c, 12, 12) << 9) | (bits(c, 6, 6) << 4) | (bits(c, 5, 5) << 6) |
+                                             (bits(c, 4, 3) << 7) | (bits(c, 2, 2) << 5),
+                                         10);
+                return encode_i(0x13, 2, 0, 2, imm);
+            }
+            return ((uint32_t)imm6 << 12) | (rd << 7) | 0x37;  // C.LUI
+        case 014:
+            switch (bits(c, 11, 10))
+            {
+                case 0: return encode_r(0x13, rs1_, 5, rs1_, rs2, 0x00);  // C.SRLI
+                case 1: return encode_r(0x13, rs1_, 5, rs1_, rs2, 0x20);  // C.SRAI
+                case 2: return encode_i(0x13, rs1_, 7, rs1_, imm6);       // C.ANDI
+                default:
+                {
+                    static const uint32_t f3[4] = {0, 4, 6, 7};  // C.SUB, C.XOR, C.OR, C.AND
+                    if (bits(c, 12, 12))
+                        break;
+                    return encode_r(0x33, rs1_, f3[bits(c, 6, 5)], rs1_, rd_, bits(c, 6, 5) == 0 ? 0x20 : 0);
+                }
+            }
+            break;
+        case 015: return encode_j(0, j_imm);                           // C.J
+        case 016: return encode_b(0, rs1_, 0, b_imm);                  // C.BEQZ
+        case 017: return encode_b(1, rs1_, 0, b_imm);                  // C.BNEZ
+        case 020: return encode_r(0x13, rd, 1, rd, rs2, 0);            // C.SLLI
+        case 022:                                                      // C.LWSP
+            return encode_i(0x03, rd, 2, 2, (bits(c, 12, 12) << 5) | (bits(c, 6, 4) << 2) | (bits(c, 3, 2) << 6));
+        case 024:
+            if (!bits(c, 12, 12))
+                return rs2 ? encode_r(0x33, rd, 0, 0, rs2, 0)  // C.MV
+                           : encode_i(0x67, 0, 0, rd, 0);      // C.JR
+            if (rd == 0 && rs2 == 0)
+                return 0x00100073;  // C.EBREAK
+            return rs2 ? encode_r(0x33, rd, 0, rd, rs2, 0)     // C.ADD
+                       : encode_i(0x67, 1, 0, rd, 0);          // C.JALR
+        case 026:                                                      // C.SWSP
+            return encode_s(0x23, 2, 2, rs2, (bits(c, 12, 9) << 2) | (bits(c, 8, 7) << 6));
+    }
+
+    fault("Illegal compressed instruction", c);
+    return 0;
+}
+
+// Execute one instruction
+static void step(void)
+{
+    uint32_t insn = load(pc, 2);
+    uint32_t next = pc + 2;
+    if ((insn & 3) == 3)
+    {
+        insn = load(pc, 4);
+        next = pc + 4;
+    }
+    else
+        insn = expand(insn);
+
+    const uint32_t op  = bits(insn, 6, 0);
+    const uint32_t rd  = bits(insn, 11, 7);
+    const uint32_t f3  = bits(insn, 14, 12);
+    const uint32_t rs1 = bits(insn, 19, 15);
+    const uint32_t rs2 = bits(insn, 24, 20);
+    const uint32_t f7  = bits(insn, 31, 25);
+    const int32_t  i_imm = sext(bits(insn, 31, 20), 12);
+    const int32_t  s_imm = sext((f7 << 5) | rd, 12);
+    uint32_t       cost  = CYCLES_ALU;
+
+    switch (op)
+    {
+        case 0x37: set_reg(rd, insn & 0xFFFFF000); break;       // LUI
+        case 0x17: set_reg(rd, pc + (insn & 0xFFFFF000)); break;  // AUIPC
+        case 0x6F:                                                // JAL
+            set_reg(rd, next);
+            next = pc + sext((bits(insn, 31, 31) << 20) | (bits(insn, 19, 12) << 12) | (bits(insn, 20, 20) << 11) |
+                                 (bits(insn, 30, 21) << 1),
+                             21);
+            cost = CYCLES_JUMP;
+            break;
+        case 0x67:  // JALR
+        {
+            const uint32_t target = (reg(rs1) + i_imm) & ~1u;
+            set_reg(rd, next);
+            next = target;
+            cost = CYCLES_JUMP;
+            break;
+        }
+        case 0x63:  // Branch
+        {
+            const uint32_t a = reg(rs1), b = reg(rs2);
+            int            taken;
+            switch (f3)
+            {
+                case 0: taken = a == b; break;
+                case 1: taken = a != b; break;
+                case 4: taken = (int32_t)a < (int32_t)b; break;
+                case 5: taken = (int32_t)a >= (int32_t)b; break;
+                case 6: taken = a < b; break;
+                case 7: taken = a >= b; break;
+                default: fault("Illegal branch", insn);
+            }
+            cost = CYCLES_BRANCH;
+            if (taken)
+            {
+                next = pc + sext((bits(insn, 31, 31) << 12) | (bits(insn, 7, 7) << 11) | (bits(insn, 30, 25) << 5) |
+                                     (bits(insn, 11, 8) << 1),
+                                 13);
+                cost = CYCLES_JUMP;
+            }
+            break;
+        }
+        case 0x03:  // Load
+        {
+            const uint32_t addr = reg(rs1) + i_imm;
+            switch (f3)
+            {
+                case 0: set_reg(rd, sext(load(addr, 1), 8)); break;
+                case 1: set_reg(rd, sext(load(addr, 2), 16)); break;
+                case 2: set_reg(rd, load(addr, 4)); break;
+                case 4: set_reg(rd, load(addr, 1)); break;
+                case 5: set_reg(rd, load(addr, 2)); break;
+                default: fault("Illegal load", insn);
+            }
+            cost = CYCLES_LOAD;
+            break;
+        }
+        case 0x23:  // Store
+            if (f3 > 2)
+                fault("Illegal store", insn);
+            store(reg(rs1) + s_imm, 1u << f3, reg(rs2));
+            cost = CYCLES_STORE;
+            break;
+        case 0x13:  // ALU immediate
+        case 0x33:  // ALU register
+        {
+            const uint32_t a     = reg(rs1);
+            const uint32_t b     = op == 0x13 ? (uint32_t)i_imm : reg(rs2);
+            const uint32_t shamt = b & 31;
+            uint32_t       v;
+            if (op == 0x33 && f7 & 1)
+                fault("No M extension on rv32ec", insn);
+            switch (f3)
+            {
+                case 0: v = (op == 0x33 && f7 == 0x20) ? a - b : a + b; break;
+                case 1: v = a << shamt; break;
+                case 2: v = (int32_t)a < (int32_t)b; break;
+                case 3: v = a < b; break;
+                case 4: v = a ^ b; break;
+                case 5: v = (f7 & 0x20) ? (uint32_t)((int32_t)a >> shamt) : a >> shamt; break;
+                case 6: v = a | b; break;
+                default: v = a & b; break;
+            }
+            set_reg(rd, v);
+            break;
+        }
+        case 0x0F: break;  // FENCE
+        case 0x73:         // System
+            if (f3 == 0)
+            {
+                if (insn == 0x30200073)  // MRET
+                {
+                    next = csr[0x341];
+                    cost = CYCLES_JUMP;
+                }
+                else if (insn != 0x10500073)  // WFI is a NOP here
+                    fault("ECALL or EBREAK", pc);
+            }
+            else
+            {
+                const uint32_t n   = bits(insn, 31, 20);
+                const uint32_t old = csr[n];
+                const uint32_t src = (f3 & 4) ? rs1 : reg(rs1);
+                switch (f3 & 3)
+                {
+                    case 1: csr[n] = src; break;
+                    case 2: if (rs1) csr[n] = old | src; break;
+                    case 3: if (rs1) csr[n] = old & ~src; break;
+                }
+                set_reg(rd, old);
+            }
+            break;
+        default: fault("Illegal instruction", insn);
+    }
+
+    pc = next;
+    instructions++;
+    cycles += cost;
+}
+
+// ELF
+typedef struct
+{
+    uint8_t  ident[16];
+    uint16_t type, machine;
+    uint32_t version, entry, phoff, shoff, flags;
+    uint16_t ehsize, phentsize, phnum, shentsize, shnum, shstrndx;
+} elf_header_t;
+
+typedef struct
+{
+    uint32_t type, offset, vaddr, paddr, filesz, memsz, flags, align;
+} elf_segment_t;
+
+typedef struct
+{
+    uint32_t name, type, flags, addr, offset, size, link, info, addralign, entsize;
+} elf_section_t;
+
+typedef struct
+{
+    uint32_t name, value, size;
+    uint8_t  info, other;
+    uint16_t shndx;
+} elf_symbol_t;
+
+static uint8_t*            elf;
+static const elf_symbol_t* symbols;
+static uint32_t            symbol_count;
+static const char*         symbol_names;
+
+static void load_elf(const char* path)
+{
+    FILE* f = fopen(path, "rb");
+    if (!f)
+    {
+        perror(path);
+        exit(2);
+    }
+    fseek(f, 0, SEEK_END);
+    const long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    elf = malloc(size);
+    if (fread(elf, 1, size, f) != (size_t)size)
+    {
+        perror(path);
+        exit(2);
+    }
+    fclose(f);
+
+    const elf_header_t* h = (const elf_header_t*)elf;
+    if (memcmp(h->ident, "\177ELF\1\1", 6) || h->machine != 243)
+    {
+        fprintf(stderr, "%s: Not a 32-bit little-endian RISC-V ELF\n", path);
+        exit(2);
+    }
+
+    for (int i = 0; i < h->phnum; i++)
+    {
+        const elf_segment_t* s = (const elf_segment_t*)(elf + h->phoff + i * h->phentsize);
+        if (s->type != 1 || s->memsz == 0)  // PT_LOAD
+            continue;
+        uint8_t* p = mem(s->vaddr, s->memsz);
+        memset(p, 0, s->memsz);
+        memcpy(p, elf + s->offset, s->filesz);
+    }
+
+    for (int i = 0; i < h->shnum; i++)
+    {
+        const elf_section_t* s = (const elf_section_t*)(elf + h->shoff + i * h->shentsize);
+        if (s->type != 2)  // SHT_SYMTAB
+            continue;
+        const elf_section_t* strtab = (const elf_section_t*)(elf + h->shoff + s->link * h->shentsize);
+        symbols      = (const elf_symbol_t*)(elf + s->offset);
+        symbol_count = s->size / sizeof(elf_symbol_t);
+        symbol_names = (const char*)(elf + strtab->offset);
+    }
+}
+
+static int find_symbol(const char* name, uint32_t* value)
+{
+    for (uint32_t i = 0; i < symbol_count; i++)
+        if (symbols[i].shndx && strcmp(symbol_names + symbols[i].name, name) == 0)
+        {
+            *value = symbols[i].value;
+            return 1;
+        }
+    return 0;
+}
+
+static uint32_t symbol(const char* name)
+{
+    uint32_t value;
+    if (!find_symbol(name, &value))
+    {
+        fprintf(stderr, "Symbol %s not found\n", name);
+        exit(2);
+    }
+    return value;
+}
+
+// Calls
+typedef struct
+{
+    char     name[64];
+    uint32_t args[MAX_ARGS];
+    int      arg_count;
+    int      count;
+    uint64_t min_instructions, max_instructions, total_instructions;
+    uint64_t min_cycles, max_cycles, total_cycles;
+} call_t;
+
+static void parse_call(const char* spec, call_t* call)
+{
+    char  buf[256];
+    char* p;
+
+    memset(call, 0, sizeof(*call));
+    snprintf(buf, sizeof(buf), "%s", spec);
+
+    call->count = 1;
+    if ((p = strchr(buf, '*')))
+    {
+        *p++        = 0;
+        call->count = atoi(p);
+    }
+
+    if ((p = strchr(buf, ':')))
+    {
+        *p++ = 0;
+        for (char* arg = strtok(p, ","); arg; arg = strtok(NULL, ","))
+        {
+            if (call->arg_count == MAX_ARGS)
+            {
+                fprintf(stderr, "%s: More than %d args\n", spec, MAX_ARGS);
+                exit(2);
+            }
+            call->args[call->arg_count++] = arg[0] == '@' ? symbol(arg + 1) : (uint32_t)strtoul(arg, NULL, 0);
+        }
+    }
+    snprintf(call->name, sizeof(call->name), "%.63s", buf);
+}
+
+// One call from entry to its return, counting instructions and cycles from 0
+static void run(uint32_t entry, uint32_t gp, const uint32_t* args)
+{
+    memset(x, 0, sizeof(x));
+    x[1]  = RETURN_MAGIC;                     // ra
+    x[2]  = 0x20000000 + sizeof(sram);        // sp
+    x[3]  = gp;                               // gp
+    memcpy(&x[10], args, MAX_ARGS * sizeof(uint32_t));  // a0-a5
+    csr[0x341] = RETURN_MAGIC;                // mepc, for handlers returning with MRET
+    pc           = entry;
+    instructions = 0;
+    cycles       = 0;
+
+    while (pc != RETURN_MAGIC)
+    {
+        step();
+        if (instructions > CALL_LIMIT)
+            fault("No return after 1M instructions, last", pc);
+    }
+}
+
+static void run_call(call_t* call)
+{
+    const uint32_t entry = symbol(call->name);
+    uint32_t       gp    = 0;
+
+    find_symbol("__global_pointer$", &gp);
+    call->min_instructions = call->min_cycles = UINT64_MAX;
+
+    for (int n = 0; n < call->count; n++)
+    {
+        run(entry, gp, call->args);
+
+        call->total_instructions += instructions;
+        call->total_cycles += cycles;
+        if (instructions < call->min_instructions)
+            call->min_instructions = instructions;
+        if (instructions > call->max_instructions)
+            call->max_instructions = instructions;
+        if (cycles < call->min_cycles)
+            call->min_cycles = cycles;
+        if (cycles > call->max_cycles)
+            call->max_cycles = cycles;
+    }
+}
+
+// Decoder and cycle model check against rv32ec_test.s, encoded by llvm-mc rather than by expand() and encode_*()
+static int self_test(void)
+{
+    static const uint32_t args[MAX_ARGS] = {0};
+
+    memcpy(flash, rv32ec_test, sizeof(rv32ec_test));
+
+    run(0, 0, args);
+    if (x[10])
+    {
+        printf("Self-test: check %u failed\n", x[10]);
+        return 1;
+    }
+
+    run(RV32EC_TEST_TIMING, 0, args);
+    if (instructions != 12 || cycles != 19)
+    {
+        printf("Self-test: timing %llu instructions %llu cycles, expected 12 and 19\n",
+               (unsigned long long)instructions, (unsigned long long)cycles);
+        return 1;
+    }
+
+    printf("Self-test passed\n");
+    return 0;
+}
+
+static void usage(const char* name)
+{
+    fprintf(stderr,
+            "Usage: %s [-o results.json] firmware.elf call...\n"
+            "       %s -t\n"
+            "  -o file  Write the results as JSON\n"
+            "  call     name[:arg,...][*count], args are numbers or @symbol\n"
+            "  -t       Run the self-test of the decoder and the cycle model\n",
+            name, name);
+    exit(2);
+}
+
+int main(int argc, char** argv)
+{
+    const char* output = NULL;
+    int         opt;
+
+    while ((opt = getopt(argc, argv, "o:t")) != -1)
+    {
+        switch (opt)
+        {
+            case 'o': output = optarg; break;
+            case 't': return self_test();
+            default: usage(argv[0]);
+        }
+    }
+    if (optind > argc - 2)
+        usage(argv[0]);
+
+    load_elf(argv[optind]);
+
+    const int call_count = argc - optind - 1;
+    call_t*   calls      = calloc(call_count, sizeof(call_t));
+
+    printf("%-28s %5s  %-22s %-22s\n", "Call", "Count", "Instructions min/avg/max", "Cycles min/avg/max");
+    for (int i = 0; i < call_count; i++)
+    {
+        const char* spec = argv[optind + 1 + i];
+        parse_call(spec, &calls[i]);
+        run_call(&calls[i]);
+
+        char insn_s[32], cycle_s[32];
+        snprintf(insn_s, sizeof(insn_s), "%llu/%llu/%llu", (unsigned long long)calls[i].min_instructions,
+                 (unsigned long long)(calls[i].total_instructions / calls[i].count),
+                 (unsigned long long)calls[i].max_instructions);
+        snprintf(cycle_s, sizeof(cycle_s), "%llu/%llu/%llu", (unsigned long long)calls[i].min_cycles,
+                 (unsigned long long)(calls[i].total_cycles / calls[i].count),
+                 (unsigned long long)calls[i].max_cycles);
+        printf("%-28s %5d  %-22s %-22s\n", spec, calls[i].count, insn_s, cycle_s);
+    }
+
+    if (output)
+    {
+        FILE* f = fopen(output, "w");
+        if (!f)
+        {
+            perror(output);
+            return 2;
+        }
+        fprintf(f, "{\n  \"cpu\": \"rv32ec\",\n  \"cycle_model\": \"QingKe V2A, flash 0 wait states\",\n");
+        fprintf(f, "  \"results\": [\n");
+        for (int i = 0; i < call_count; i++)
+        {
+            const call_t* c = &calls[i];
+            fprintf(f, "    {\"call\": \"%s\", \"function\": \"%s\", \"count\": %d, ", argv[optind + 1 + i], c->name,
+                    c->count);
+            fprintf(f, "\"instructions\": {\"min\": %llu, \"mean\": %.1f, \"max\": %llu}, ",
+                    (unsigned long long)c->min_instructions, (double)c->total_instructions / c->count,
+                    (unsigned long long)c->max_instructions);
+            fprintf(f, "\"cycles\": {\"min\": %llu, \"mean\": %.1f, \"max\": %llu}}%s\n",
+                    (unsigned long long)c->min_cycles, (double)c->total_cycles / c->count,
+                    (unsigned long long)c->max_cycles, i < call_count - 1 ? "," : "");
+        }
+        fprintf(f, "  ]\n}\n");
+        fclose(f);
+    }
+
+    return 0;
+}
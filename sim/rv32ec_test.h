@@ -0,0 +1,65 @@
+/*
+ * CH32V003 Segment LCD - RV32EC ISS Self-Test
+ *
+ * rv32ec_test.s encoded for flash at 0, regenerate after changing it with
+ *   llvm-mc -triple=riscv32 -mattr=+e,+c,-relax -filetype=obj rv32ec_test.s -o rv32ec_test.o
+ *   llvm-objcopy -O binary rv32ec_test.o rv32ec_test.bin
+ * and dump the bytes here, e.g. with xxd -i rv32ec_test.bin. Update RV32EC_TEST_TIMING from llvm-objdump -d.
+ */
+
+#define RV32EC_TEST_TIMING 0x324  // Address of timing
+
+static const uint8_t rv32ec_test[] = {
+    0x6f, 0x00, 0x00, 0x01, 0x05, 0x05, 0x82, 0x80, 0x13, 0x05, 0x70, 0x00, 0x67, 0x80, 0x00, 0x00,
+    0x93, 0x07, 0x00, 0x00, 0x6d, 0x54, 0x93, 0x87, 0x17, 0x00, 0x93, 0x03, 0xb0, 0xff, 0x63, 0x11,
+    0x74, 0x30, 0x1d, 0x04, 0x93, 0x87, 0x17, 0x00, 0x93, 0x03, 0x20, 0x00, 0x63, 0x1a, 0x74, 0x2e,
+    0xfd, 0x64, 0x93, 0x87, 0x17, 0x00, 0xb7, 0xf3, 0x01, 0x00, 0x63, 0x93, 0x74, 0x2e, 0x92, 0x04,
+    0x93, 0x87, 0x17, 0x00, 0xb7, 0x03, 0x1f, 0x00, 0x63, 0x9c, 0x74, 0x2c, 0xb1, 0x80, 0x93, 0x87,
+    0x17, 0x00, 0x93, 0x03, 0x00, 0x1f, 0x63, 0x95, 0x74, 0x2c, 0x41, 0x55, 0x09, 0x85, 0x93, 0x87,
+    0x17, 0x00, 0x93, 0x03, 0xc0, 0xff, 0x63, 0x1d, 0x75, 0x2a, 0x79, 0x89, 0x93, 0x87, 0x17, 0x00,
+    0x93, 0x03, 0xc0, 0x01, 0x63, 0x16, 0x75, 0x2a, 0xa6, 0x85, 0xaa, 0x95, 0x93, 0x87, 0x17, 0x00,
+    0x93, 0x03, 0xc0, 0x20, 0x63, 0x9e, 0x75, 0x28, 0x89, 0x8d, 0x93, 0x87, 0x17, 0x00, 0x93, 0x03,
+    0x00, 0x1f, 0x63, 0x97, 0x75, 0x28, 0xa9, 0x8d, 0x93, 0x87, 0x17, 0x00, 0x93, 0x03, 0xc0, 0x1e,
+    0x63, 0x90, 0x75, 0x28, 0xc9, 0x8d, 0x93, 0x87, 0x17, 0x00, 0x93, 0x03, 0xc0, 0x1f, 0x63, 0x99,
+    0x75, 0x26, 0xe9, 0x8d, 0x93, 0x87, 0x17, 0x00, 0x93, 0x03, 0xc0, 0x01, 0x63, 0x92, 0x75, 0x26,
+    0x3d, 0x71, 0x30, 0x00, 0x2e, 0xc6, 0x00, 0xc2, 0xa2, 0x46, 0x93, 0x87, 0x17, 0x00, 0x93, 0x03,
+    0x20, 0x00, 0x63, 0x97, 0x76, 0x24, 0x58, 0x42, 0x93, 0x87, 0x17, 0x00, 0x93, 0x03, 0xc0, 0x01,
+    0x63, 0x10, 0x77, 0x24, 0xb3, 0x06, 0x26, 0x40, 0x93, 0x87, 0x17, 0x00, 0x93, 0x03, 0x80, 0x00,
+    0x63, 0x98, 0x76, 0x22, 0x05, 0x61, 0x8a, 0x86, 0x93, 0x87, 0x17, 0x00, 0xb7, 0x13, 0x00, 0x20,
+    0x93, 0x83, 0x03, 0x80, 0x63, 0x9e, 0x76, 0x20, 0x01, 0x45, 0x11, 0xc1, 0x05, 0x45, 0x11, 0xe1,
+    0x0d, 0x05, 0x93, 0x87, 0x17, 0x00, 0x93, 0x03, 0x30, 0x00, 0x63, 0x13, 0x75, 0x20, 0x11, 0xa0,
+    0x25, 0x45, 0x93, 0x87, 0x17, 0x00, 0x93, 0x03, 0x30, 0x00, 0x63, 0x1b, 0x75, 0x1e, 0x86, 0x82,
+    0xd1, 0x3d, 0x93, 0x87, 0x17, 0x00, 0x93, 0x03, 0x40, 0x00, 0x63, 0x13, 0x75, 0x1e, 0x91, 0x45,
+    0x82, 0x95, 0x96, 0x80, 0x93, 0x87, 0x17, 0x00, 0x93, 0x03, 0x50, 0x00, 0x63, 0x1a, 0x75, 0x1c,
+    0x7d, 0x55, 0x85, 0x45, 0x01, 0x46, 0x63, 0x43, 0xb5, 0x00, 0x05, 0x06, 0x63, 0x53, 0xb5, 0x00,
+    0x09, 0x06, 0x63, 0x63, 0xb5, 0x00, 0x11, 0x06, 0x63, 0x73, 0xb5, 0x00, 0x21, 0x06, 0x63, 0x03,
+    0xb5, 0x00, 0x41, 0x06, 0x63, 0x14, 0xa5, 0x00, 0x13, 0x06, 0x06, 0x02, 0x93, 0x87, 0x17, 0x00,
+    0x93, 0x03, 0x60, 0x03, 0x63, 0x1e, 0x76, 0x18, 0x01, 0x46, 0x95, 0x46, 0x0d, 0x06, 0xfd, 0x16,
+    0xf5, 0xfe, 0x93, 0x87, 0x17, 0x00, 0x93, 0x03, 0xf0, 0x00, 0x63, 0x13, 0x76, 0x18, 0x37, 0x55,
+    0x34, 0x12, 0x13, 0x05, 0x85, 0x67, 0x93, 0x87, 0x17, 0x00, 0xb7, 0x53, 0x34, 0x12, 0x93, 0x83,
+    0x83, 0x67, 0x63, 0x17, 0x75, 0x16, 0x93, 0x55, 0x45, 0x40, 0x93, 0x87, 0x17, 0x00, 0xb7, 0x43,
+    0x23, 0x01, 0x93, 0x83, 0x73, 0x56, 0x63, 0x9d, 0x75, 0x14, 0x37, 0x05, 0x00, 0x80, 0x93, 0x55,
+    0xf5, 0x41, 0x93, 0x87, 0x17, 0x00, 0x93, 0x03, 0xf0, 0xff, 0x63, 0x93, 0x75, 0x14, 0x13, 0x07,
+    0x10, 0x02, 0xb3, 0x55, 0xe5, 0x00, 0x93, 0x87, 0x17, 0x00, 0xb7, 0x03, 0x00, 0x40, 0x63, 0x99,
+    0x75, 0x12, 0xb3, 0x95, 0xe5, 0x00, 0x93, 0x87, 0x17, 0x00, 0xb7, 0x03, 0x00, 0x80, 0x63, 0x91,
+    0x75, 0x12, 0xb3, 0x26, 0x05, 0x00, 0x93, 0x87, 0x17, 0x00, 0x93, 0x03, 0x10, 0x00, 0x63, 0x99,
+    0x76, 0x10, 0xb3, 0x36, 0x05, 0x00, 0x93, 0x87, 0x17, 0x00, 0x93, 0x03, 0x00, 0x00, 0x63, 0x91,
+    0x76, 0x10, 0x93, 0x36, 0x10, 0x00, 0x93, 0x87, 0x17, 0x00, 0x93, 0x03, 0x10, 0x00, 0x63, 0x99,
+    0x76, 0x0e, 0x93, 0xc6, 0xf6, 0xff, 0x93, 0x87, 0x17, 0x00, 0x93, 0x03, 0xe0, 0xff, 0x63, 0x91,
+    0x76, 0x0e, 0x41, 0x11, 0x37, 0xf5, 0x81, 0x80, 0x13, 0x05, 0x35, 0x2f, 0x2a, 0xc0, 0x83, 0x05,
+    0x01, 0x00, 0x93, 0x87, 0x17, 0x00, 0x93, 0x03, 0x30, 0xff, 0x63, 0x93, 0x75, 0x0c, 0x83, 0x45,
+    0x11, 0x00, 0x93, 0x87, 0x17, 0x00, 0x93, 0x03, 0x20, 0x0f, 0x63, 0x9b, 0x75, 0x0a, 0x83, 0x15,
+    0x21, 0x00, 0x93, 0x87, 0x17, 0x00, 0xb7, 0x83, 0xff, 0xff, 0x93, 0x83, 0x13, 0x08, 0x63, 0x91,
+    0x75, 0x0a, 0x83, 0x55, 0x21, 0x00, 0x93, 0x87, 0x17, 0x00, 0xb7, 0x83, 0x00, 0x00, 0x93, 0x83,
+    0x13, 0x08, 0x63, 0x97, 0x75, 0x08, 0xa3, 0x01, 0x01, 0x00, 0x23, 0x10, 0x01, 0x00, 0x82, 0x45,
+    0x93, 0x87, 0x17, 0x00, 0xb7, 0x03, 0x81, 0x00, 0x63, 0x9c, 0x75, 0x06, 0x41, 0x01, 0x17, 0x05,
+    0x00, 0x00, 0x97, 0x05, 0x00, 0x00, 0x33, 0x85, 0xa5, 0x40, 0x93, 0x87, 0x17, 0x00, 0x93, 0x03,
+    0x40, 0x00, 0x63, 0x1f, 0x75, 0x04, 0x86, 0x82, 0x81, 0x33, 0x93, 0x87, 0x17, 0x00, 0x93, 0x03,
+    0x70, 0x00, 0x63, 0x17, 0x75, 0x04, 0x91, 0x45, 0xe7, 0x80, 0x45, 0x00, 0x96, 0x80, 0x93, 0x87,
+    0x17, 0x00, 0x93, 0x03, 0x70, 0x00, 0x63, 0x1d, 0x75, 0x02, 0x05, 0x65, 0x13, 0x05, 0x45, 0x23,
+    0x73, 0x10, 0x05, 0x34, 0xf3, 0xe5, 0x01, 0x34, 0x93, 0x87, 0x17, 0x00, 0xb7, 0x13, 0x00, 0x00,
+    0x93, 0x83, 0x43, 0x23, 0x63, 0x9e, 0x75, 0x00, 0xf3, 0x25, 0x00, 0x34, 0x93, 0x87, 0x17, 0x00,
+    0xb7, 0x13, 0x00, 0x00, 0x93, 0x83, 0x73, 0x23, 0x63, 0x94, 0x75, 0x00, 0x01, 0x45, 0x82, 0x80,
+    0x3e, 0x85, 0x82, 0x80, 0x0d, 0x45, 0x7d, 0x15, 0x7d, 0xfd, 0x7d, 0x71, 0x2a, 0xc0, 0x82, 0x45,
+    0x41, 0x61, 0x82, 0x80,
+};
@@ -0,0 +1,182 @@
+# CH32V003 Segment LCD - RV32EC ISS Self-Test
+#
+# Encoded into rv32ec_test.h, run by rv32ec_iss -t from flash at 0.
+# - The checks at 0 return a0 = 0 if all pass, else the number of the failed check.
+# - timing returns after a known count of instructions and cycles of the cycle model.
+    .macro check reg, val
+    .option norvc
+    addi  a5, a5, 1
+    li    t2, \val
+    bne   \reg, t2, fail
+    .option rvc
+    .endm
+    .text
+_start:
+    .option norvc
+    j       start
+sub_c:                          # 4
+    .option rvc
+    c.addi  a0, 1
+    c.jr    ra
+sub_32:                         # 8
+    .option norvc
+    li      a0, 7
+    jalr    zero, 0(ra)
+start:
+    li      a5, 0
+    .option rvc
+    # Compressed ALU
+    c.li    s0, -5
+    check   s0, -5
+    c.addi  s0, 7
+    check   s0, 2
+    c.lui   s1, 0x1f
+    check   s1, 0x1f000
+    c.slli  s1, 4
+    check   s1, 0x1f0000
+    c.srli  s1, 12
+    check   s1, 0x1f0
+    c.li    a0, -16
+    c.srai  a0, 2
+    check   a0, -4
+    c.andi  a0, 0x1e
+    check   a0, 0x1c
+    c.mv    a1, s1
+    c.add   a1, a0
+    check   a1, 0x20c
+    c.sub   a1, a0
+    check   a1, 0x1f0
+    c.xor   a1, a0
+    check   a1, 0x1ec
+    c.or    a1, a0
+    check   a1, 0x1fc
+    c.and   a1, a0
+    check   a1, 0x1c
+    # Compressed loads and stores, sp forms
+    c.addi16sp sp, -32
+    c.addi4spn a2, sp, 8
+    c.swsp  a1, 12(sp)
+    c.sw    s0, 0(a2)
+    c.lwsp  a3, 8(sp)
+    check   a3, 2
+    c.lw    a4, 4(a2)
+    check   a4, 0x1c
+    sub     a3, a2, sp
+    check   a3, 8
+    c.addi16sp sp, 32
+    c.mv    a3, sp
+    check   a3, 0x20000800
+    # Compressed branches and jumps
+    c.li    a0, 0
+    c.beqz  a0, 1f
+    c.li    a0, 1
+1:  c.bnez  a0, 2f
+    c.addi  a0, 3
+2:  check   a0, 3
+    c.j     3f
+    c.li    a0, 9
+3:  check   a0, 3
+    c.mv    t0, ra
+    c.jal   sub_c
+    check   a0, 4
+    c.li    a1, 4               # sub_c, code runs at 0
+    c.jalr  a1
+    c.mv    ra, t0
+    check   a0, 5
+    # Branches, taken and not taken, signed and unsigned
+    li      a0, -1
+    li      a1, 1
+    li      a2, 0
+    blt     a0, a1, 4f
+    addi    a2, a2, 1
+4:  bge     a0, a1, 5f
+    addi    a2, a2, 2
+5:  bltu    a0, a1, 6f
+    addi    a2, a2, 4
+6:  bgeu    a0, a1, 7f
+    addi    a2, a2, 8
+7:  beq     a0, a1, 8f
+    addi    a2, a2, 16
+8:  bne     a0, a0, 9f
+    addi    a2, a2, 32
+9:  check   a2, 0x36
+    # Backward branch loop
+    li      a2, 0
+    li      a3, 5
+10: addi    a2, a2, 3
+    addi    a3, a3, -1
+    bnez    a3, 10b
+    check   a2, 15
+    # 32-bit ALU, shifts and compares
+    li      a0, 0x12345678
+    check   a0, 0x12345678
+    srai    a1, a0, 4
+    check   a1, 0x01234567
+    li      a0, 0x80000000
+    srai    a1, a0, 31
+    check   a1, -1
+    li      a4, 33
+    srl     a1, a0, a4
+    check   a1, 0x40000000
+    sll     a1, a1, a4
+    check   a1, 0x80000000
+    slt     a3, a0, zero
+    check   a3, 1
+    sltu    a3, a0, zero
+    check   a3, 0
+    sltiu   a3, zero, 1
+    check   a3, 1
+    xori    a3, a3, -1
+    check   a3, -2
+    # Byte and halfword loads and stores
+    addi    sp, sp, -16
+    li      a0, 0x8081f2f3
+    sw      a0, 0(sp)
+    lb      a1, 0(sp)
+    check   a1, -13
+    lbu     a1, 1(sp)
+    check   a1, 0xf2
+    lh      a1, 2(sp)
+    check   a1, -32639
+    lhu     a1, 2(sp)
+    check   a1, 0x8081
+    sb      zero, 3(sp)
+    sh      zero, 0(sp)
+    lw      a1, 0(sp)
+    check   a1, 0x00810000
+    addi    sp, sp, 16
+    # auipc, jal and jalr
+    auipc   a0, 0
+    auipc   a1, 0
+    sub     a0, a1, a0
+    check   a0, 4
+    mv      t0, ra
+    jal     sub_32
+    check   a0, 7
+    li      a1, 4
+    jalr    ra, 4(a1)           # sub_32
+    mv      ra, t0
+    check   a0, 7
+    # CSR
+    li      a0, 0x1234
+    csrw    mscratch, a0
+    csrrs   a1, mscratch, 3
+    check   a1, 0x1234
+    csrr    a1, mscratch
+    check   a1, 0x1237
+    li      a0, 0
+    ret
+fail:
+    mv      a0, a5
+    ret
+    # Timing, 12 instructions and 19 cycles
+timing:
+    .option rvc
+    c.li    a0, 3               # 1
+11: c.addi  a0, -1              # 3 x 1
+    c.bnez  a0, 11b             # 2 x 3 taken, 1 not taken
+    c.addi16sp sp, -16          # 1
+    c.swsp  a0, 0(sp)           # 1
+    c.lwsp  a1, 0(sp)           # 2
+    c.addi16sp sp, 16           # 1
+    c.jr    ra                  # 3